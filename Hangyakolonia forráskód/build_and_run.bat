@@ -1,5 +1,7 @@
 @echo off
-gcc ./src/main.c ./src/antcolony.c -I./include -L./build -lSDL3 -lSDL3_image -lSDL3_ttf -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia.exe
+rem set ID_BITS=32 before building for graphs or colonies above 65534 items
+if "%ID_BITS%"=="" set ID_BITS=16
+gcc ./src/main.c ./src/engine.c ./src/graph.c ./src/antcolony.c -I./include -DID_BITS=%ID_BITS% -L./build -lSDL3 -lSDL3_image -lSDL3_ttf -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia.exe
 if %errorlevel% equ 0 (
    echo *** Build successful, running Hangyakolonia.exe ...
    .\build\Hangyakolonia.exe
@@ -0,0 +1,17 @@
+@echo off
+rem set ID_BITS=32 before building for graphs or colonies above 65534 items
+if "%ID_BITS%"=="" set ID_BITS=16
+gcc ./src/headless.c ./src/engine.c ./src/graph.c ./src/antcolony.c -I./include -DID_BITS=%ID_BITS% -L./build -lSDL3 -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia-headless.exe
+if %errorlevel% equ 0 (
+   echo *** Build successful, usage: .\build\Hangyakolonia-headless.exe graph.txt [-t seconds] [-d dt] [-r report] [-s seed] [-j threads] [-l lazy] [-e events] [-g bias] [-m metrics] [-n ticks] [-x ticks] [-c ticks] [-E entropy] [-k checks] [-b branching] [-A alpha] [-B beta] [-Q q] [-R rate] [-W weight] [-N ants] [-w binary] [-p result]
+) else (
+   echo Build script failed.
+   exit /b 1
+)
+rem parameter sweep, runs the headless build above as its colonies
+gcc ./src/sweep.c -I./include -L./build -lSDL3 -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia-sweep.exe
+if %errorlevel% equ 0 (
+   echo *** Build successful, usage: .\build\Hangyakolonia-sweep.exe graph.txt [-o results.csv] [-j processes] [-s seeds] [-n samples] [-a/-b/-q/-r/-w/-c values] [-- headless options]
+) else (
+   echo Build script failed.
+)
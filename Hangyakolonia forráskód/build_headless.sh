@@ -0,0 +1,11 @@
+#!/bin/sh
+# headless build for Linux, needs SDL3 installed (no SDL3_image, SDL3_ttf or display)
+# ID_BITS=32 ./build_headless.sh for graphs or colonies above 65534 items
+# ./tests/check_headless.sh runs the checks on the build
+gcc ./src/headless.c ./src/engine.c ./src/graph.c ./src/antcolony.c -I./include -DID_BITS=${ID_BITS:-16} -lSDL3 -lm -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia-headless \
+    && echo "*** Build successful, usage: ./build/Hangyakolonia-headless graph.txt [-t seconds] [-d dt] [-r report] [-s seed] [-j threads] [-l lazy] [-e events] [-g bias] [-m metrics] [-n ticks] [-x ticks] [-c ticks] [-E entropy] [-k checks] [-b branching] [-A alpha] [-B beta] [-Q q] [-R rate] [-W weight] [-N ants] [-w binary] [-p result]" \
+    || echo "Build script failed."
+# parameter sweep, runs the headless build above as its colonies
+gcc ./src/sweep.c -I./include -lSDL3 -std=c99 -Wall -Wextra -Werror -pedantic -Wno-unused-parameter -O3 -o build/Hangyakolonia-sweep \
+    && echo "*** Build successful, usage: ./build/Hangyakolonia-sweep graph.txt [-o results.csv] [-j processes] [-s seeds] [-n samples] [-a/-b/-q/-r/-w/-c values] [-- headless options]" \
+    || echo "Build script failed."
@@ -10,7 +10,23 @@
 #define HOMING_IMG_PATH     "./resources/ant_yellow.png"
 #define FONT_PATH           "./resources/dejavusans.ttf"
 
+/* width of node, edge and ant ids: 16 bits keeps small graphs cache dense, 
+   build with -DID_BITS=32 for graphs or colonies above 65534 items */
+#ifndef ID_BITS
+#define ID_BITS             16
+#endif
+
+#if ID_BITS == 16
+typedef uint16_t id;
 #define MAX                 (0xFFFF)
+#define MAX_ANTS            (MAX - 1)
+#elif ID_BITS == 32
+typedef uint32_t id;
+#define MAX                 (0xFFFFFFFF)
+#define MAX_ANTS            (SDL_MAX_SINT32) /* Ants.count is an int */
+#else
+#error "ID_BITS must be 16 or 32"
+#endif
 #define EMPTY               (MAX)
 #define WIN_WIDTH           1680
 #define WIN_HEIGHT          970
@@ -23,7 +39,6 @@
 
 //#define DEBUG 
 
-typedef uint16_t id;
 typedef struct { int x; int y; } coord_t;
 
 struct nodes_s {
@@ -35,6 +50,10 @@ struct nodes_s {
     id           size;
 };
 
+/* Edges.pheromones is aligned to and padded up to a whole vector of this many bytes for the evaporation kernels */
+#define VECTOR_BYTES        32
+#define VECTOR_PADDED(n)    (((size_t)(n) + VECTOR_BYTES / sizeof(float) - 1) & ~(VECTOR_BYTES / sizeof(float) - 1))
+
 struct edges_s {
     SDL_FColor   color;
     SDL_Vertex * verts;
@@ -42,31 +61,81 @@ struct edges_s {
     float      * widths;
     float      * lengths;
     float      * pheromones;
+    float      * heuristics;     /* (1/length)^Beta */
+    float      * attractiveness; /* pheromone^Alpha * heuristic */
+    uint32_t   * epochs;         /* evaporation interval the edge's pheromone is up to date with */
     id         * anodes;
     id         * bnodes;
+    uint32_t     epoch;          /* evaporation intervals elapsed, advances instead of the full pass in lazy mode */
     id           capacity;
     id           size;
 };
 
-struct paths_s {
-    id         * nodes;
+#define HUB_DEGREE          16 /* nodes with at least this many edges sample from a prefix sum table */
+
+/* frozen CSR adjacency built at simulation start: slots of node n are offsets[n]..offsets[n+1]-1; 
+   nodes and edges outside the Nest's component or on dead ends are pruned and have no slots, degrees counts the rest; 
+   runs of degree 2 nodes (other than Nest and Food) are contracted into chains, a slot leads through a whole chain: 
+   edges is the chain's edge at the node, tails the one at the far end (others), lengths the chain's length; 
+   the edges of chain c are chainEdges[chainOffsets[c]..chainOffsets[c+1]-1] from chainEnds[c][0] to chainEnds[c][1]; 
+   prefix holds the running attractiveness sum over a hub's slots, rebuilt lazily when the hub is dirty */
+struct adjacency_s {
+    int        * offsets;
     id         * edges;
-    int          chunksize;
+    id         * tails;
+    id         * others;
+    float      * lengths;
+    float      * prefix;
+    bool       * dirty;
+    id         * hubs;
+    id         * degrees;
+    float      * distances;      /* shortest distance to Food over the slots, -1 where there is none */
+    float      * biases;         /* per slot multiplier of the distance heuristic, 1 when it is off */
+    id         * chains;         /* chain of each edge, EMPTY on pruned edges and rings without a stop */
+    int        * chainOffsets;
+    id         * chainEdges;
+    id        (* chainEnds)[2];
+    float      * chainLengths;
+    int          chaincount;
+    int          hubcount;
+    int          size;
+};
+
+#define PATH_CHUNK          16
+
+/* one step of an ant's walk: the edge it arrived on (its chain's end at node), the node and the walk's length up to it */
+struct step_s {
+    float        length;
+    id           edge;
+    id           node;
+};
+
+/* per ant walks, the first PATH_CHUNK steps of every ant live in one pooled block, 
+   longer walks move to their own block grown on demand; 
+   visits is a per ant open addressing table of step indices, keyed by the step's node, 
+   entries are checked against the walk so truncated ones go stale without being removed */
+struct paths_s {
+    struct step_s  * pool;
+    struct step_s ** steps;
+    id             * capacities;
+    id             * vpool;
+    id            ** visits;
+    uint32_t       * vcapacities;
+    uint32_t       * vsizes;
+    int              count;      /* ants the paths were allocated for, Ants.count may change before the next start */
 };
 
+/* structure of arrays, hot fields of the on-edge pass first */
 struct ants_s {
-    struct {
-        float    progress;
-        float    pathlength;
-        int      TTL;
-        id       src;
-        id       dest;
-        id       edge;
-        id       pathidx;
-        bool     foraging;
-    } * colony;
-    float   * probabilitiesBuffer;
-    id      * edgesBuffer;
+    float   * progress;
+    float   * rates;        /* 1 / length of the current edge */
+    float   * pathlengths;
+    int     * TTLs;
+    id      * srcs;
+    id      * dests;
+    id      * edges;        /* edge of the current chain at dests, the one the ant arrives on */
+    id      * pathidxs;
+    bool    * foraging;
     int count;
     int actives;
 };
@@ -79,10 +148,53 @@ struct grids_s {
     int capacity;
 };
 
+struct graph_s; /* a graph read by a background load, see InstallGraph */
+
+/* early termination criteria, 0 turns one off; checked every interval ticks, the first one met ends the run */
+struct convergence_s {
+    uint64_t maxTicks;   /* hard budget, checked every tick */
+    int      interval;
+    float    entropy;    /* normalized pheromone entropy below this */
+    int      patience;   /* this many checks in a row without a shorter best walk */
+    float    branching;  /* mean lambda-branching factor below this, near 1 */
+};
+
+/* convergence metrics, see EngineGetMetrics */
+struct engine_metrics_s {
+    float    optimum;
+    float    best;
+    double   mean;
+    double   optimal;
+    double   entropy;
+};
+
+/* what the simulation thread publishes for rendering, see EngineAcquireSnapshot */
+struct engine_snapshot_s {
+    uint64_t     ticks;
+    int          ants;        /* active ants */
+    int          antcap;
+    SDL_FPoint * positions;   /* centers of the active ants */
+    bool       * foraging;
+    id           edges;
+    id           edgecap;
+    float      * pheromones;  /* per edge */
+};
+
+struct engine_state_s {
+    uint64_t ticks;
+    double   time;
+    float    pheromones;
+    int      count;
+    int      actives;
+    int      foraging;
+    int      homing;
+};
+
 extern struct edges_s   Edges;
 extern struct nodes_s   Nodes;
 extern struct ants_s    Ants;
 extern struct paths_s   Paths;
+extern struct adjacency_s Adjacency;
 extern struct grids_s   Grids;
 extern id Nest;
 extern id Food;
@@ -95,6 +207,10 @@ extern float AntSpeed;
 extern float PheromoneMin;
 extern float PheromoneMax;
 extern float Weight;
+extern bool  LazyEvaporation;
+extern float FoodBias;
+extern Uint32 GraphSavedEvent; /* user event type of a finished background save, 0 before the first one */
+extern Uint32 GraphLoadedEvent; /* user event type of a finished background load, 0 before the first one */
 
 /* memory handling functions */
 void InitializeNodes(void);
@@ -102,6 +218,10 @@ void InitializeGrids(void);
 void InitializeEdges(void);
 void InitializeAnts(void);
 void InitializePaths(void);
+void GrowPath(id);
+void GrowVisits(id);
+void InitializeAdjacency(void);
+void InitializeGraph(void);
 void AddNewNode(int, int);
 void AddNewEdge(id, id);
 void FreeNodes(void);
@@ -109,6 +229,23 @@ void FreeGrids(void);
 void FreeEdges(void);
 void FreeAnts(void);
 void FreePaths(void);
+void FreeAdjacency(void);
+bool IsChainNode(id);
+id   OtherChainEnd(id);
+bool FoodReachable(void);
+void ComputeFoodDistances(void);
+void FreeGraph(void);
+id   SearchNodeInArea(int, int, int);
+
+/* saving and loading graph */
+void SaveGraph(void);
+void WaitGraphSaves(void);
+bool LoadGraph(const char *);
+bool LoadGraphAsync(const char *);
+int  GraphLoadProgress(void);
+void CancelGraphLoad(void);
+void InstallGraph(struct graph_s *);
+bool SaveGraphBinary(const char *);
 
 /* rendering functions */
 void RenderNodes(void);
@@ -122,7 +259,44 @@ void RenderDebugCircle(int, int);
 /* ant colony algorithm's functions */
 void UpdateAnts(float);
 void EvaporatePheromones(float);
+void ResetEvaporation(void);
+void MaterializePheromones(void);
+float CurrentPheromone(id);
+float BestWalk(void);
+void ResetBestWalk(void);
+void RefreshAttractiveness(void);
+void InitializeWorkers(int);
+void FreeWorkers(void);
+void InitializeEvents(void);
+void FreeEvents(void);
+void ScheduleAnt(id, double);
+void UpdateAntsUntil(double);
 void ResetBaseAlgorithmParams(void);
 void ResetBaseAntParams(id);
 
+/* headless simulation engine */
+bool EngineInit(const char *);
+void EngineStart(void);
+void EngineStep(float);
+int  EngineAdvance(float, int);
+void EngineSetThreads(int);
+void EngineSetLazyEvaporation(bool);
+void EngineSetEventDriven(bool);
+void EngineSetFood(id);
+void EngineSetAntCount(int);
+bool EngineSetMetrics(const char *, int);
+void EngineSetConvergence(const struct convergence_s *);
+bool EngineConverged(void);
+void EngineGetState(struct engine_state_s *);
+void EngineGetMetrics(struct engine_metrics_s *);
+void EngineFree(void);
+bool EngineStartThread(void);
+void EngineStopThread(void);
+void EngineLock(void);
+void EngineUnlock(void);
+void EngineSetRunning(bool, int);
+const struct engine_snapshot_s * EngineAcquireSnapshot(void);
+void FreeSnapshots(void);
+bool ValidateGraph(void);
+
 #endif //GLOBAL_H
@@ -1,4 +1,6 @@
 #include <global.h>
+#include <SDL3/SDL_intrin.h>
+#include <stdlib.h>
 
 float EvaporationRate;
 float EvaporationInterval;
@@ -9,41 +11,361 @@ float AntSpeed;
 float PheromoneMin;
 float PheromoneMax;
 float Weight;
+bool  LazyEvaporation;
+float FoodBias;                  /* exponent of the distance to Food heuristic, 0 = off */
 
 static float evaporationTimer = 0.0f;
+static float cachedAlpha;        /* Alpha and Beta the attractiveness table was built with */
+static float cachedBeta;
+static float cachedBias;
+static float bestWalk = -1.0f;   /* shortest walk an ant has carried from Food since ResetBestWalk */
+
+/* pheromone deposited by a worker, merged into Edges.pheromones after the update */
+struct deposit_s {
+    id           edge;
+    float        value;
+};
+
+/* per-thread state of the ant update: scratch buffers, random stream, ant range */
+struct worker_s {
+    SDL_Thread       * thread;
+    SDL_Semaphore    * start;
+    float            * probabilitiesBuffer;
+    int              * slotsBuffer;
+    struct deposit_s * deposits;
+    int                dcapacity;
+    int                dsize;
+    float              best;     /* shortest walk carried from Food in this update, -1 for none */
+    Uint64             rng;
+    float              elapsedSecs;
+    int                first;
+    int                last;
+    bool               quit;
+};
+
+static struct {
+    struct worker_s  * pool;
+    SDL_Semaphore    * done;
+    int                count;
+} Workers;
+
+/* next node arrival of an ant in the event-driven mode */
+struct event_s {
+    double       time;
+    id           ant;
+};
+
+/* binary min-heap of arrivals, at most one per ant */
+static struct {
+    struct event_s   * heap;
+    int                size;
+    int                capacity;
+} Events;
 
 /* helper functions */
-static inline id   SelectEdgeAtNode(id, id);
-static inline void DepositPheromone(id, id);
-static inline void Homing(id);
-static inline void Foraging(id);
-static inline void ForagingGetNext(id);
-static inline id GetOtherNodeOnEdge(id, id);
-static inline int GetPathStart(id);
+static inline int  SelectEdgeAtNode(struct worker_s *, id, id);
+static inline int  SelectEdgeAtHub(struct worker_s *, id, id);
+static inline int  SearchPrefix(int, int, float);
+static void RebuildPrefix(id);
+static inline void DepositPheromone(struct worker_s *, id, id);
+static inline void Homing(struct worker_s *, id);
+static inline void Foraging(struct worker_s *, id);
+static inline void ForagingGetNext(struct worker_s *, id);
+static inline void RefreshEdgeAttractiveness(id);
+static inline float PheromonePower(float);
+static inline float DecayedPheromone(id);
+static inline void MaterializeEdge(id);
+static inline float CurrentAttractiveness(id);
+static void RefreshAllAttractiveness(void);
+static void RefreshBiases(void);
+static void EvaporateScalar(float *, int, float, float, float, float);
+static inline id   FindVisit(id, id, id);
+static inline void AddVisit(id, id, id);
+static void RebuildVisits(id, id);
+static void UpdateAntRange(struct worker_s *);
+static void PushEvent(double, id);
+static struct event_s PopEvent(void);
+static int SDLCALL WorkerThread(void *);
+static void MergeBestWalks(void);
 
+/* sequential on the calling thread with one worker, otherwise split across the pool */
 void UpdateAnts(float elapsedSecs) {
-    for (id a = 0; a < Ants.actives; a++) {
-        if (Ants.colony[a].progress >= 1.0f) { /* arrived to a node */
-            Ants.colony[a].src = Ants.colony[a].dest;
-            if (Ants.colony[a].foraging) Foraging(a); 
-            else Homing(a);
-        
-        } else { /* on edge */
-            float length = Edges.lengths[Ants.colony[a].edge];
-            Ants.colony[a].progress += (elapsedSecs * AntSpeed) / length;
+    if (Alpha != cachedAlpha || Beta != cachedBeta || FoodBias != cachedBias) RefreshAttractiveness();
+
+    int count = Workers.count;
+    if (count <= 1) {
+        Workers.pool[0].first = 0;
+        Workers.pool[0].last = Ants.actives;
+        Workers.pool[0].elapsedSecs = elapsedSecs;
+        UpdateAntRange(&Workers.pool[0]);
+        MergeBestWalks();
+        return;
+    }
+
+    /* the workers only read the hub tables, so bring the stale ones up to date beforehand */
+    for (int h = 0; h < Adjacency.hubcount; h++)
+        if (Adjacency.dirty[Adjacency.hubs[h]]) RebuildPrefix(Adjacency.hubs[h]);
+
+    int chunk = (Ants.actives + count - 1) / count;
+    for (int w = 0; w < count; w++) {
+        struct worker_s * worker = &Workers.pool[w];
+        worker->first = SDL_min(w * chunk, Ants.actives);
+        worker->last  = SDL_min(worker->first + chunk, Ants.actives);
+        worker->elapsedSecs = elapsedSecs;
+        worker->dsize = 0;
+        if (w > 0) SDL_SignalSemaphore(worker->start);
+    }
+
+    UpdateAntRange(&Workers.pool[0]); /* the calling thread is worker 0 */
+    for (int w = 1; w < count; w++) SDL_WaitSemaphore(Workers.done);
+
+    /* merging deposits in worker order keeps runs with the same thread count reproducible */
+    for (int w = 0; w < count; w++) {
+        struct worker_s * worker = &Workers.pool[w];
+        for (int d = 0; d < worker->dsize; d++) {
+            id e = worker->deposits[d].edge;
+            MaterializeEdge(e);
+            Edges.pheromones[e] += worker->deposits[d].value;
+            RefreshEdgeAttractiveness(e);
+        }
+    }
+    MergeBestWalks();
+}
+
+/* the workers' shortest walks of the update into bestWalk */
+static void MergeBestWalks(void) {
+    for (int w = 0; w < Workers.count; w++) {
+        struct worker_s * worker = &Workers.pool[w];
+        if (worker->best >= 0.0f && (bestWalk < 0.0f || worker->best < bestWalk)) bestWalk = worker->best;
+        worker->best = -1.0f;
+    }
+}
+
+/* shortest walk an ant has carried from Food, -1 before the first one */
+float BestWalk(void) {
+    return bestWalk;
+}
+
+void ResetBestWalk(void) {
+    bestWalk = -1.0f;
+}
+
+/* rebuilds the pheromone^Alpha * (1/length)^Beta table and the slot biases, 
+   needed after changing Alpha, Beta, FoodBias, lengths or Food */
+void RefreshAttractiveness(void) {
+    cachedAlpha = Alpha;
+    cachedBeta  = Beta;
+    for (id e = 0; e < Edges.size; e++)
+        Edges.heuristics[e] = Beta == 1.0f ? 1.0f / Edges.lengths[e] : SDL_powf((1.0f / Edges.lengths[e]), Beta);
+    RefreshBiases();
+    RefreshAllAttractiveness();
+}
+
+/* (distance to Food from the node / distance through the slot)^FoodBias: 1 on the shortest routes, 
+   smaller the longer the detour; 1 everywhere without Food or with FoodBias = 0 */
+static void RefreshBiases(void) {
+    cachedBias = FoodBias;
+    const float * distances = Adjacency.distances;
+    for (id n = 0; n < Nodes.size; n++) {
+        for (int k = Adjacency.offsets[n]; k < Adjacency.offsets[n + 1]; k++) {
+            float through = Adjacency.lengths[k] + distances[Adjacency.others[k]];
+            bool biased = FoodBias > 0.0f && distances[n] > 0.0f && distances[Adjacency.others[k]] >= 0.0f;
+            Adjacency.biases[k] = biased ? SDL_powf(distances[n] / through, FoodBias) : 1.0f;
         }
     }
 }
 
+/* after a pass over every pheromone: Alpha = 1 (the default) skips the powf, all hub tables go stale */
+static void RefreshAllAttractiveness(void) {
+    float * restrict attractiveness = Edges.attractiveness;
+    const float * restrict pheromones = Edges.pheromones;
+    const float * restrict heuristics = Edges.heuristics;
+    int size = Edges.size;
+    if (Alpha == 1.0f) {
+        for (int e = 0; e < size; e++) attractiveness[e] = pheromones[e] * heuristics[e];
+    } else {
+        for (int e = 0; e < size; e++) attractiveness[e] = SDL_powf(pheromones[e], Alpha) * heuristics[e];
+    }
+    SDL_memset(Adjacency.dirty, true, Nodes.size * sizeof(*Adjacency.dirty));
+}
+
+static void UpdateAntRange(struct worker_s * w) {
+    float step = w->elapsedSecs * AntSpeed;
+    float * restrict progress = Ants.progress;
+    const float * restrict rates = Ants.rates;
+
+    /* on edge - ants waiting at a node have zero rate */
+    for (int a = w->first; a < w->last; a++)
+        progress[a] += step * rates[a];
+
+    for (int a = w->first; a < w->last; a++) {
+        if (progress[a] < 1.0f) continue;
+        do { /* arrived to a node - the distance walked past it carries onto the next edge */
+            float overshoot = Ants.rates[a] > 0.0f ? (Ants.progress[a] - 1.0f) / Ants.rates[a] : 0.0f;
+            Ants.rates[a] = 0.0f;
+            Ants.srcs[a] = Ants.dests[a];
+            if (Ants.foraging[a]) Foraging(w, a); 
+            else Homing(w, a);
+            Ants.progress[a] += overshoot * Ants.rates[a];
+        } while (Ants.progress[a] >= 1.0f && Ants.rates[a] > 0.0f); /* waiting ants resume next tick */
+    }
+}
+
+static int SDLCALL WorkerThread(void * data) {
+    struct worker_s * w = data;
+    for (;;) {
+        SDL_WaitSemaphore(w->start);
+        if (w->quit) break;
+        UpdateAntRange(w);
+        SDL_SignalSemaphore(Workers.done);
+    }
+    return 0;
+}
+
+/* runs after the graph has been created; each worker gets its own random stream from the seeded SDL_rand */
+void InitializeWorkers(int count) {
+    if (count < 1) count = 1;
+
+    int maxdegree = 0;
+    for (id n = 0; n < Nodes.size; n++)
+        maxdegree = SDL_max(maxdegree, (int)Nodes.esizes[n]);
+
+    Workers.count = count;
+    Workers.pool  = SDL_calloc(count, sizeof(*Workers.pool));
+    Workers.done  = SDL_CreateSemaphore(0);
+    if (!Workers.pool || !Workers.done) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    for (int w = 0; w < count; w++) {
+        struct worker_s * worker = &Workers.pool[w];
+        worker->probabilitiesBuffer = SDL_malloc((maxdegree + 1) * sizeof(*worker->probabilitiesBuffer));
+        worker->slotsBuffer         = SDL_malloc((maxdegree + 1) * sizeof(*worker->slotsBuffer));
+        worker->dcapacity           = 64;
+        worker->deposits            = SDL_malloc(worker->dcapacity * sizeof(*worker->deposits));
+        worker->best                = -1.0f;
+        worker->rng                 = ((Uint64)SDL_rand_bits() << 32) | SDL_rand_bits();
+        if (!worker->probabilitiesBuffer || !worker->slotsBuffer || !worker->deposits) {
+            SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+
+        if (w > 0) {
+            worker->start  = SDL_CreateSemaphore(0);
+            worker->thread = SDL_CreateThread(WorkerThread, "AntWorker", worker);
+            if (!worker->start || !worker->thread) {
+                SDL_Log("Creating worker thread failed: %s\n", SDL_GetError());
+                exit(1);
+            }
+        }
+    }
+}
+
+void FreeWorkers(void) {
+    for (int w = 0; w < Workers.count; w++) {
+        struct worker_s * worker = &Workers.pool[w];
+        if (worker->thread) {
+            worker->quit = true;
+            SDL_SignalSemaphore(worker->start);
+            SDL_WaitThread(worker->thread, NULL);
+        }
+        SDL_DestroySemaphore(worker->start);
+        SDL_free(worker->probabilitiesBuffer);
+        SDL_free(worker->slotsBuffer);
+        SDL_free(worker->deposits);
+    }
+    SDL_DestroySemaphore(Workers.done);
+    SDL_free(Workers.pool);
+    Workers.pool  = NULL;
+    Workers.done  = NULL;
+    Workers.count = 0;
+}
+
+/* event-driven mode: sequential, runs after InitializeWorkers(1) */
+void InitializeEvents(void) {
+    Events.capacity = Paths.count;
+    Events.size     = 0;
+    Events.heap     = SDL_malloc(Events.capacity * sizeof(*Events.heap));
+    if (!Events.heap) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+}
+
+void FreeEvents(void) {
+    SDL_free(Events.heap);
+    Events.heap     = NULL;
+    Events.size     = 0;
+    Events.capacity = 0;
+}
+
+/* an ant just activated at the Nest, it makes its first move at time */
+void ScheduleAnt(id a, double time) {
+    PushEvent(time, a);
+}
+
+/* handles every arrival up to time in time order; ants in transit are not touched, 
+   so their progress is only known from their arrival time */
+void UpdateAntsUntil(double time) {
+    if (Alpha != cachedAlpha || Beta != cachedBeta || FoodBias != cachedBias) RefreshAttractiveness();
+
+    struct worker_s * w = &Workers.pool[0];
+    while (Events.size > 0 && Events.heap[0].time <= time) {
+        struct event_s event = PopEvent();
+        id a = event.ant;
+
+        /* ants stopping at the Nest or Food move on at once, the tick loop would wait a tick */
+        Ants.progress[a] = 1.0f;
+        do {
+            Ants.rates[a] = 0.0f;
+            Ants.srcs[a] = Ants.dests[a];
+            if (Ants.foraging[a]) Foraging(w, a);
+            else Homing(w, a);
+        } while (Ants.rates[a] == 0.0f);
+
+        PushEvent(event.time + 1.0 / ((double)Ants.rates[a] * AntSpeed), a);
+    }
+    MergeBestWalks();
+}
+
+static void PushEvent(double time, id a) {
+    int i = Events.size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (Events.heap[parent].time <= time) break;
+        Events.heap[i] = Events.heap[parent];
+        i = parent;
+    }
+    Events.heap[i] = (struct event_s) { time, a };
+}
+
+static struct event_s PopEvent(void) {
+    struct event_s top  = Events.heap[0];
+    struct event_s last = Events.heap[--Events.size];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= Events.size) break;
+        if (child + 1 < Events.size && Events.heap[child + 1].time < Events.heap[child].time) child++;
+        if (last.time <= Events.heap[child].time) break;
+        Events.heap[i] = Events.heap[child];
+        i = child;
+    }
+    Events.heap[i] = last;
+    return top;
+}
+
 inline void ResetBaseAntParams(id a) {
-    Ants.colony[a].progress     = 1.0f;
-    Ants.colony[a].pathlength   = 0.0f;
-    Ants.colony[a].src          = Nest;
-    Ants.colony[a].dest         = Nest;
-    Ants.colony[a].edge         = EMPTY;
-    Ants.colony[a].pathidx      = 0;
-    Ants.colony[a].foraging     = true;
-    Ants.colony[a].TTL          = Nodes.size * 2;
+    Ants.progress[a]    = 1.0f;
+    Ants.rates[a]       = 0.0f;
+    Ants.pathlengths[a] = 0.0f;
+    Ants.srcs[a]        = Nest;
+    Ants.dests[a]       = Nest;
+    Ants.edges[a]       = EMPTY;
+    Ants.pathidxs[a]    = 0;
+    Ants.foraging[a]    = true;
+    Ants.TTLs[a]        = Nodes.size * 2;
 }
 
 inline void ResetBaseAlgorithmParams(void) {
@@ -58,148 +380,378 @@ inline void ResetBaseAlgorithmParams(void) {
     Weight              = 1.0f;
 }
 
-/* updating the edges' pheromone values */
+/* evaporation kernels, k intervals at once: pheromones[i] = max(min(pheromones[i] * factor, max) * carry, min) 
+   with factor = 1 - rate and carry = factor^(k-1), the same as k clamped passes since only the first can hit max; 
+   the vector ones run over the padded length, the padding is never read elsewhere */
+static void EvaporateScalar(float * restrict pheromones, int count, float factor, float carry, float min, float max) {
+    for (int i = 0; i < count; i++) {
+        float p = pheromones[i] * factor;
+        p = (p > max ? max : p) * carry;
+        pheromones[i] = p < min ? min : p;
+    }
+}
+
+#ifdef SDL_SSE_INTRINSICS
+static void SDL_TARGETING("sse") EvaporateSSE(float * pheromones, int count, float factor, float carry, float min, float max) {
+    __m128 f = _mm_set1_ps(factor), c = _mm_set1_ps(carry), lo = _mm_set1_ps(min), hi = _mm_set1_ps(max);
+    for (size_t i = 0; i < VECTOR_PADDED(count); i += 4) {
+        __m128 p = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(_mm_load_ps(pheromones + i), f), hi), c);
+        _mm_store_ps(pheromones + i, _mm_max_ps(p, lo));
+    }
+}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") EvaporateAVX2(float * pheromones, int count, float factor, float carry, float min, float max) {
+    __m256 f = _mm256_set1_ps(factor), c = _mm256_set1_ps(carry), lo = _mm256_set1_ps(min), hi = _mm256_set1_ps(max);
+    for (size_t i = 0; i < VECTOR_PADDED(count); i += 8) {
+        __m256 p = _mm256_mul_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_load_ps(pheromones + i), f), hi), c);
+        _mm256_store_ps(pheromones + i, _mm256_max_ps(p, lo));
+    }
+}
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+static void EvaporateNEON(float * pheromones, int count, float factor, float carry, float min, float max) {
+    float32x4_t lo = vdupq_n_f32(min), hi = vdupq_n_f32(max);
+    for (size_t i = 0; i < VECTOR_PADDED(count); i += 4) {
+        float32x4_t p = vmulq_n_f32(vminq_f32(vmulq_n_f32(vld1q_f32(pheromones + i), factor), hi), carry);
+        vst1q_f32(pheromones + i, vmaxq_f32(p, lo));
+    }
+}
+#endif
+
+/* picks the widest kernel the cpu runs, once */
+static void (*SelectEvaporateKernel(void))(float *, int, float, float, float, float) {
+#ifdef SDL_AVX2_INTRINSICS
+    if (SDL_HasAVX2()) return EvaporateAVX2;
+#endif
+#ifdef SDL_SSE_INTRINSICS
+    if (SDL_HasSSE()) return EvaporateSSE;
+#endif
+#ifdef SDL_NEON_INTRINSICS
+    if (SDL_HasNEON()) return EvaporateNEON;
+#endif
+    return EvaporateScalar;
+}
+
+/* a new run starts a whole interval before the first evaporation */
+void ResetEvaporation(void) {
+    evaporationTimer = 0.0f;
+}
+
+/* updating the edges' pheromone values, a step spanning several intervals evaporates all of them in one pass */
 void EvaporatePheromones(float elapsedSecs) {
+    static void (*evaporate)(float *, int, float, float, float, float) = NULL;
+    if (!evaporate) evaporate = SelectEvaporateKernel();
+
     evaporationTimer += elapsedSecs;
     if (evaporationTimer >= EvaporationInterval) {
-        for (id e = 0; e < Edges.size; e++) {
-            float p = Edges.pheromones[e] * (1.0f - EvaporationRate);
-            p = p < PheromoneMin ? PheromoneMin : p > PheromoneMax ? PheromoneMax : p;
-            Edges.pheromones[e] = p;
+        uint32_t k = 1;
+        if (EvaporationInterval > 0.0f) {
+            k = (uint32_t)(evaporationTimer / EvaporationInterval);
+            evaporationTimer -= k * EvaporationInterval;
+        }
+
+        if (LazyEvaporation) { /* edges catch up when touched, only the hub tables go stale now */
+            Edges.epoch += k;
+            for (int h = 0; h < Adjacency.hubcount; h++) Adjacency.dirty[Adjacency.hubs[h]] = true;
+        } else {
+            float factor = 1.0f - EvaporationRate;
+            float carry = k > 1 ? SDL_powf(factor, (float)(k - 1)) : 1.0f;
+            evaporate(Edges.pheromones, Edges.size, factor, carry, PheromoneMin, PheromoneMax);
+            RefreshAllAttractiveness();
         }
-        evaporationTimer -= EvaporationInterval;
     }
 }
 
-/* picking next edge by probability distribution, exclude source edge if possible */ 
-static inline id SelectEdgeAtNode(id node, id prevEdge) {
-    id count   = Nodes.esizes[node];
-    id * edges = Nodes.edges[node];
+/* the edge's pheromone after the intervals it missed: clamped like the full pass, 
+   only the first interval can hit PheromoneMax and after that only PheromoneMin */
+static inline float DecayedPheromone(id edge) {
+    uint32_t k = Edges.epoch - Edges.epochs[edge];
+    float p = Edges.pheromones[edge];
+    if (k == 0) return p;
+
+    float factor = 1.0f - EvaporationRate;
+    p = SDL_min(p * factor, PheromoneMax);
+    if (k > 1) p *= SDL_powf(factor, (float)(k - 1));
+    return SDL_max(p, PheromoneMin);
+}
+
+/* writes the edge's decay back, not for the workers */
+static inline void MaterializeEdge(id edge) {
+    if (Edges.epochs[edge] == Edges.epoch) return;
+    Edges.pheromones[edge] = DecayedPheromone(edge);
+    Edges.epochs[edge] = Edges.epoch;
+    RefreshEdgeAttractiveness(edge);
+}
+
+/* the workers share the edges, so with more of them the decay is computed without writing it back */
+static inline float CurrentAttractiveness(id edge) {
+    if (Edges.epochs[edge] == Edges.epoch) return Edges.attractiveness[edge];
+    if (Workers.count <= 1) {
+        MaterializeEdge(edge);
+        return Edges.attractiveness[edge];
+    }
+    return PheromonePower(DecayedPheromone(edge)) * Edges.heuristics[edge];
+}
+
+/* brings every lazily evaporated edge up to date, before rendering or reading all pheromones */
+void MaterializePheromones(void) {
+    if (!LazyEvaporation) return;
+    for (id e = 0; e < Edges.size; e++) MaterializeEdge(e);
+}
+
+/* the edge's pheromone with the lazy evaporation it missed, without writing it back */
+float CurrentPheromone(id edge) {
+    return DecayedPheromone(edge);
+}
+
+/* picking next edge by probability distribution, exclude source edge if possible; returns its Adjacency slot */ 
+static inline int SelectEdgeAtNode(struct worker_s * w, id node, id prevEdge) {
+    int first = Adjacency.offsets[node];
+    int last  = Adjacency.offsets[node + 1];
+    if (last - first >= HUB_DEGREE) return SelectEdgeAtHub(w, node, prevEdge);
     
     int b = 0;
     float totalProbability = 0.0f;
-    for (int i = 0; i < count; i++) {
-        id e = edges[i];
+    for (int k = first; k < last; k++) {
+        id e = Adjacency.edges[k];
         if (e == prevEdge) { /* exclude source edge by default */
             continue;
         }
 
-        float pheromone = SDL_powf(Edges.pheromones[e], Alpha);
-        float heuristic = SDL_powf((1.0f / Edges.lengths[e]), Beta);
-        float probability = pheromone * heuristic;
+        float probability = CurrentAttractiveness(e) * Adjacency.biases[k];
 
-        Ants.probabilitiesBuffer[b] = probability;
-        Ants.edgesBuffer[b] = e;
+        w->probabilitiesBuffer[b] = probability;
+        w->slotsBuffer[b] = k;
         totalProbability += probability;
         b++;
     }
 
 #ifdef DEBUG
     SDL_Log("Total probabilites = %f\n", totalProbability);
-    for (int i = 0; i < b; i++) { SDL_Log("\t[%d] edge's probability = %f\n", Ants.edgesBuffer[i], Ants.probabilitiesBuffer[i]); }
+    for (int i = 0; i < b; i++) { SDL_Log("\t[%d] edge's probability = %f\n", Adjacency.edges[w->slotsBuffer[i]], w->probabilitiesBuffer[i]); }
 #endif
 
-    float r = SDL_randf() * totalProbability;
+    float r = SDL_randf_r(&w->rng) * totalProbability;
     float rsum = 0.0f;
-    id selected = edges[0];
+    int selected = first;
     for (int i = 0; i < b; i++) {
-        rsum += Ants.probabilitiesBuffer[i];
+        rsum += w->probabilitiesBuffer[i];
         if (r <= rsum) {
-            selected = Ants.edgesBuffer[i];
+            selected = w->slotsBuffer[i];
             break;
         }
     }
 
 #ifdef DEBUG
-    SDL_Log("Selected edge = [%d] (r = %f, rsum = %f)\n", selected, r, rsum);
+    SDL_Log("Selected edge = [%d] (r = %f, rsum = %f)\n", Adjacency.edges[selected], r, rsum);
 #endif
 
     return selected;
 }
 
-static inline void DepositPheromone(id edge, id ant) {
-    float value = Q / SDL_powf(Ants.colony[ant].pathlength, Weight);
-    Edges.pheromones[edge] += value;
+/* same distribution as the roulette wheel in O(log degree): binary search in the node's prefix sums, 
+   a draw landing on the source edge is redrawn over the remaining slots with that segment cut out */
+static inline int SelectEdgeAtHub(struct worker_s * w, id node, id prevEdge) {
+    int first = Adjacency.offsets[node];
+    int last  = Adjacency.offsets[node + 1];
+    if (Adjacency.dirty[node]) RebuildPrefix(node); /* only in sequential mode, flushed before the workers run */
+
+    const float * prefix = Adjacency.prefix;
+    float total = prefix[last - 1];
+    int k = SearchPrefix(first, last, SDL_randf_r(&w->rng) * total);
+    if (Adjacency.edges[k] != prevEdge) return k;
+
+    float before = k > first ? prefix[k - 1] : 0.0f;
+    float excluded = prefix[k] - before;
+    float rest = total - excluded;
+    if (rest <= 0.0f) return k;
+
+    float r = SDL_randf_r(&w->rng) * rest;
+    if (r >= before) r += excluded;
+    int selected = SearchPrefix(first, last, r);
+    if (selected == k) selected = k + 1 < last ? k + 1 : k - 1; /* rounding at the segment's border */
+    return selected;
+}
+
+/* first slot whose running sum is above r, the last slot if rounding pushed r past the total */
+static inline int SearchPrefix(int first, int last, float r) {
+    const float * prefix = Adjacency.prefix;
+    int lo = first, hi = last - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (prefix[mid] > r) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
 }
 
-static inline void Homing(id a) {
-    int p = GetPathStart(a) + Ants.colony[a].pathidx;
-    id e  = Paths.edges[p];
-    Ants.colony[a].edge = e;
+/* never runs on the workers, so lazily evaporated edges can be written back */
+static void RebuildPrefix(id node) {
+    float sum = 0.0f;
+    for (int k = Adjacency.offsets[node]; k < Adjacency.offsets[node + 1]; k++) {
+        id e = Adjacency.edges[k];
+        MaterializeEdge(e);
+        sum += Edges.attractiveness[e] * Adjacency.biases[k];
+        Adjacency.prefix[k] = sum;
+    }
+    Adjacency.dirty[node] = false;
+}
 
-    if (Ants.colony[a].pathidx == 0) { /* finished backtracking */
-        if (Ants.colony[a].src == Nest) {
+/* on every edge of the edge's chain; with more workers the deposit is logged and merged after the update */
+static inline void DepositPheromone(struct worker_s * w, id edge, id ant) {
+    float value = Q / SDL_powf(Ants.pathlengths[ant], Weight);
+    id c = Adjacency.chains[edge];
+    int first = Adjacency.chainOffsets[c];
+    int last  = Adjacency.chainOffsets[c + 1];
+    if (Workers.count <= 1) {
+        for (int i = first; i < last; i++) {
+            id e = Adjacency.chainEdges[i];
+            MaterializeEdge(e);
+            Edges.pheromones[e] += value;
+            RefreshEdgeAttractiveness(e);
+        }
+        return;
+    }
+
+    while (w->dsize + (last - first) > w->dcapacity) {
+        w->dcapacity *= 2;
+        w->deposits = SDL_realloc(w->deposits, w->dcapacity * sizeof(*w->deposits));
+        if (!w->deposits) {
+            SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+    for (int i = first; i < last; i++)
+        w->deposits[w->dsize++] = (struct deposit_s) { Adjacency.chainEdges[i], value };
+}
+
+static inline void Homing(struct worker_s * w, id a) {
+    struct step_s * path = Paths.steps[a];
+    id p = Ants.pathidxs[a];
+    id e = path[p].edge; /* the chain's edge at this node */
+    Ants.edges[a] = OtherChainEnd(e);
+    Ants.rates[a] = 1.0f / Adjacency.chainLengths[Adjacency.chains[e]];
+
+    if (Ants.pathidxs[a] == 0) { /* finished backtracking */
+        if (Ants.srcs[a] == Nest) {
             ResetBaseAntParams(a);
         } else { /* finished backtracking - travel last edge to the nest */
-            DepositPheromone(e, a);
-            Ants.colony[a].dest = Nest;
-            Ants.colony[a].progress = 0.0f;
+            DepositPheromone(w, e, a);
+            Ants.dests[a] = Nest;
+            Ants.progress[a] = 0.0f;
         }
     } else { /* backtracking */
-        DepositPheromone(e, a);
-        Ants.colony[a].dest = Paths.nodes[p - 1];
-        Ants.colony[a].pathidx--;
-        Ants.colony[a].progress = 0.0f;
+        DepositPheromone(w, e, a);
+        Ants.dests[a] = path[p - 1].node;
+        Ants.pathidxs[a]--;
+        Ants.progress[a] = 0.0f;
     }
 }
 
-static inline void ForagingGetNext(id a) {
-    if (--Ants.colony[a].TTL <= 0) {
+static inline void ForagingGetNext(struct worker_s * w, id a) {
+    if (--Ants.TTLs[a] <= 0) {
         ResetBaseAntParams(a);
         return;
     }
     
-    id n = Ants.colony[a].src;
-    id nextEdge = SelectEdgeAtNode(n, Ants.colony[a].edge);
-    id nextDest = GetOtherNodeOnEdge(nextEdge, n);
+    int k = SelectEdgeAtNode(w, Ants.srcs[a], Ants.edges[a]);
+    id nextEdge = Adjacency.tails[k]; /* the ant arrives on the chain's far end */
+    id nextDest = Adjacency.others[k];
 
-    Ants.colony[a].edge = nextEdge;
-    Ants.colony[a].dest = nextDest;
-    Ants.colony[a].pathlength += Edges.lengths[nextEdge];
+    Ants.edges[a] = nextEdge;
+    Ants.dests[a] = nextDest;
+    Ants.rates[a] = 1.0f / Adjacency.lengths[k];
+    Ants.pathlengths[a] += Adjacency.lengths[k];
 
-    int p = GetPathStart(a) + Ants.colony[a].pathidx++;
+    id p = Ants.pathidxs[a]++;
+    if (p >= Paths.capacities[a]) GrowPath(a);
+    Paths.steps[a][p] = (struct step_s) { Ants.pathlengths[a], nextEdge, nextDest };
 
-    Paths.edges[p] = nextEdge;
-    Paths.nodes[p] = nextDest;
-
-    Ants.colony[a].progress = 0.0f;
+    Ants.progress[a] = 0.0f;
 }
 
-static inline void Foraging(id a) {
-    id n = Ants.colony[a].src;
+static inline void Foraging(struct worker_s * w, id a) {
+    id n = Ants.srcs[a];
     if (n == Nest) {
-        if (Ants.colony[a].pathidx == 0) { /* new path start */
-            Ants.colony[a].edge = EMPTY;
-            ForagingGetNext(a);
+        if (Ants.pathidxs[a] == 0) { /* new path start */
+            Ants.edges[a] = EMPTY;
+            ForagingGetNext(w, a);
         } else { /* returned back without finding Food */
-            Ants.colony[a].pathidx = 0;
-            Ants.colony[a].pathlength = 0;
+            Ants.pathidxs[a] = 0;
+            Ants.pathlengths[a] = 0;
         }
     } else if (n == Food) {
-        Ants.colony[a].foraging = false;
-        Ants.colony[a].pathidx--;
+        float length = Ants.pathlengths[a];
+        if (w->best < 0.0f || length < w->best) w->best = length;
+        Ants.foraging[a] = false;
+        Ants.pathidxs[a]--;
     } else { /* at other node */
-        float newLength = 0.f; /* unloop */
-        int start = GetPathStart(a);
-        for (id i = 0; i < Ants.colony[a].pathidx; i++) { 
-            int p = start + i;
-            id e = Paths.edges[p];
-            newLength += Edges.lengths[e];
-            if (Ants.colony[a].src == Paths.nodes[p]) {
-                Ants.colony[a].pathlength = newLength;
-                Ants.colony[a].edge = e;
-                Ants.colony[a].pathidx = ++i;
-                break;
-            }
+        id last = Ants.pathidxs[a] - 1; /* the step that led here */
+        id i = FindVisit(a, n, last);
+        if (i != EMPTY) { /* unloop - cut the walk back to the first visit of this node */
+            struct step_s * path = Paths.steps[a];
+            Ants.pathlengths[a] = path[i].length;
+            Ants.edges[a] = path[i].edge;
+            Ants.pathidxs[a] = i + 1;
+        } else {
+            AddVisit(a, n, last);
         }
-        ForagingGetNext(a);
+        ForagingGetNext(w, a);
     }
 }
 
-static inline id GetOtherNodeOnEdge(id edge, id node) {
-    return (Edges.anodes[edge] == node) ? Edges.bnodes[edge] : Edges.anodes[edge];
+/* Fibonacci hashing of the node into a power of two table */
+static inline uint32_t HashNode(id node, uint32_t capacity) {
+    return ((uint32_t)node * 2654435769u) & (capacity - 1);
+}
+
+/* step index of the node's visit among the ant's first limit steps, or EMPTY */
+static inline id FindVisit(id a, id node, id limit) {
+    struct step_s * path = Paths.steps[a];
+    id * visits = Paths.visits[a];
+    uint32_t cap = Paths.vcapacities[a];
+    for (uint32_t h = HashNode(node, cap); visits[h] != EMPTY; h = (h + 1) & (cap - 1)) {
+        id s = visits[h];
+        if (s < limit && path[s].node == node) return s;
+    }
+    return EMPTY;
+}
+
+static inline void AddVisit(id a, id node, id step) {
+    if ((Paths.vsizes[a] + 1) * 2 > Paths.vcapacities[a]) RebuildVisits(a, step);
+
+    id * visits = Paths.visits[a];
+    uint32_t cap = Paths.vcapacities[a];
+    uint32_t h = HashNode(node, cap);
+    while (visits[h] != EMPTY) h = (h + 1) & (cap - 1);
+    visits[h] = step;
+    Paths.vsizes[a]++;
+}
+
+/* drops the stale entries by refilling the table from the walk's first count steps, grows it if still crowded */
+static void RebuildVisits(id a, id count) {
+    if (((uint32_t)count + 1) * 4 > Paths.vcapacities[a]) {
+        GrowVisits(a);
+    } else {
+        SDL_memset(Paths.visits[a], 0xFF, Paths.vcapacities[a] * sizeof(*Paths.visits[a]));
+        Paths.vsizes[a] = 0;
+    }
+
+    struct step_s * path = Paths.steps[a];
+    for (id s = 0; s < count; s++) AddVisit(a, path[s].node, s);
+}
+
+/* pheromone^Alpha, Alpha = 1 (the default) skips the powf */
+static inline float PheromonePower(float pheromone) {
+    return Alpha == 1.0f ? pheromone : SDL_powf(pheromone, Alpha);
 }
 
-static inline int GetPathStart(id ant) {
-    return ant * Paths.chunksize;
+/* also marks both ends' prefix tables stale */
+static inline void RefreshEdgeAttractiveness(id edge) {
+    Edges.attractiveness[edge] = PheromonePower(Edges.pheromones[edge]) * Edges.heuristics[edge];
+    Adjacency.dirty[Edges.anodes[edge]] = true;
+    Adjacency.dirty[Edges.bnodes[edge]] = true;
 }
@@ -0,0 +1,537 @@
+#include <global.h>
+#include <stdlib.h>
+
+static float    antTimer    = 0.0f; /* timer for the separated start of the ants */
+static float    antInterval = 0.1f;
+static uint64_t ticks       = 0;
+static double   simTime     = 0.0;
+static int      threadCount = 1;
+static bool     eventDriven = false;
+static float    fixedDt     = 1.0f / 60.0f; /* simulated seconds of one EngineAdvance step */
+static double   accumulator = 0.0;          /* simulated time owed to EngineAdvance */
+
+/* convergence metrics stream */
+static SDL_IOStream * metricsFile     = NULL;
+static bool           metricsJson     = false;
+static int            metricsInterval = 60;   /* ticks */
+static double         antTicks        = 0.0;   /* active ants summed over the ticks since the last row */
+static Uint64         metricsWall     = 0;
+
+/* early termination */
+static struct convergence_s convergence = { 0, 60, 0.0f, 0, 0.0f };
+static bool                 converged   = false;
+static float                lastBest    = -1.0f; /* best walk at the last check that improved it */
+static int                  staleChecks = 0;
+
+/* simulation thread of the window, it publishes triple-buffered snapshots: it fills the back one and exchanges it 
+   with the middle one, the renderer exchanges its front one with the middle one when that is newer; 
+   each exchange is one atomic operation, so neither side waits for the other */
+#define SNAPSHOT_FRESH  4 /* flag on the middle index, published after the last acquire */
+static struct engine_snapshot_s snapshots[3];
+static int            backSnapshot   = 0;
+static SDL_AtomicInt  middleSnapshot = { 1 };
+static int            frontSnapshot  = 2;
+static bool           snapshotStale  = true; /* the colony changed since the last publish */
+static SDL_Thread   * simThread      = NULL;
+static SDL_Mutex    * simLock        = NULL; /* held by the simulation for one step, by the window while it edits */
+static SDL_AtomicInt  simWaiting;            /* callers blocked in EngineLock, the simulation gives way to them */
+static SDL_AtomicInt  simQuit;
+static bool           simRunning     = false;
+static int            simSpeed       = 1;
+
+#define LAMBDA_BRANCHING 0.05f /* a slot counts as a branch above min + lambda * (max - min) pheromone at its node */
+
+static void EmitMetrics(void);
+static void CheckConvergence(void);
+static void PublishSnapshot(void);
+
+/* loads the graph file into an empty graph and starts the colony on it */
+bool EngineInit(const char * path) {
+    InitializeGraph();
+    ResetBaseAlgorithmParams();
+
+    if (!LoadGraph(path) || !ValidateGraph()) {
+        FreeGraph();
+        return false;
+    }
+
+    EngineStart();
+    return true;
+}
+
+/* (re)builds the adjacency, allocates the ants, their paths and the workers, resets pheromones and timers */
+void EngineStart(void) {
+    FreePaths();
+    FreeAnts();
+    FreeAdjacency();
+    FreeWorkers();
+    FreeEvents();
+    FreeSnapshots();
+
+    InitializeAdjacency();
+    InitializePaths();
+    InitializeAnts();
+    InitializeWorkers(eventDriven ? 1 : threadCount);
+    if (eventDriven) InitializeEvents();
+
+    Edges.epoch = 0;
+    ResetEvaporation();
+    ResetBestWalk();
+    for (id e = 0; e < Edges.size; e++) { /* reset pheromones */
+        Edges.pheromones[e] = PheromoneMin;
+        Edges.epochs[e] = 0;
+    }
+    RefreshAttractiveness();
+
+    antTimer    = 0.0f;
+    ticks       = 0;
+    simTime     = 0.0;
+    accumulator = 0.0;
+    antTicks    = 0.0;
+    metricsWall = SDL_GetTicksNS();
+    converged   = false;
+    lastBest    = -1.0f;
+    staleChecks = 0;
+}
+
+/* advances the colony by elapsedSecs simulated seconds */
+void EngineStep(float elapsedSecs) {
+    double stepEnd = simTime + elapsedSecs;
+
+    /* seperated start - a long step starts every ant it covers */
+    if (Ants.actives < Ants.count) {
+        antTimer += elapsedSecs;
+        while (antTimer >= antInterval && Ants.actives < Ants.count) {
+            antTimer -= antInterval;
+            if (eventDriven) ScheduleAnt(Ants.actives, stepEnd - antTimer);
+            Ants.actives++;
+        }
+    }
+
+    if (eventDriven) UpdateAntsUntil(stepEnd);
+    else UpdateAnts(elapsedSecs);
+    EvaporatePheromones(elapsedSecs);
+
+    ticks++;
+    simTime += elapsedSecs;
+
+    if (metricsFile) {
+        antTicks += Ants.actives;
+        if (ticks % metricsInterval == 0) EmitMetrics();
+    }
+    if (!converged) {
+        if (convergence.maxTicks > 0 && ticks >= convergence.maxTicks) {
+            SDL_Log("Tick budget of %" SDL_PRIu64 " reached.\n", convergence.maxTicks);
+            converged = true;
+        } else if (ticks % convergence.interval == 0) {
+            CheckConvergence();
+        }
+    }
+}
+
+/* owes the fixed steps the real time passed times the speed multiplier */
+static void AccumulateTime(float realSecs, int multiplier) {
+    if (realSecs > 0.25f) realSecs = 0.25f; /* a stalled frame is dropped rather than caught up */
+    accumulator += (double)realSecs * multiplier;
+}
+
+/* runs whole fixed steps for the real time passed times the speed multiplier, the rest is kept for the next call, 
+   so the results depend only on the number of steps and not on the frame times; returns the steps run */
+int EngineAdvance(float realSecs, int multiplier) {
+    AccumulateTime(realSecs, multiplier);
+
+    int steps = 0;
+    while (accumulator >= fixedDt) {
+        EngineStep(fixedDt);
+        accumulator -= fixedDt;
+        steps++;
+    }
+    return steps;
+}
+
+/* advances the colony in real time on a thread of its own, at its own rate, while the window only renders; 
+   it locks for one fixed step at a time and stops stepping while an edit waits, so the edit waits one step at most */
+static int SDLCALL SimulationThread(void * data) {
+    Uint64 last = SDL_GetTicksNS();
+    while (!SDL_GetAtomicInt(&simQuit)) {
+        Uint64 now = SDL_GetTicksNS();
+        SDL_LockMutex(simLock);
+        if (simRunning) AccumulateTime((now - last) / 1e9f, simSpeed);
+        SDL_UnlockMutex(simLock);
+        last = now;
+
+        bool stepped;
+        do {
+            SDL_LockMutex(simLock);
+            stepped = simRunning && accumulator >= fixedDt && !SDL_GetAtomicInt(&simWaiting);
+            if (stepped) {
+                EngineStep(fixedDt);
+                accumulator -= fixedDt;
+                snapshotStale = true;
+            } else if (snapshotStale) {
+                PublishSnapshot();
+            }
+            SDL_UnlockMutex(simLock);
+        } while (stepped);
+        SDL_DelayNS(SDL_NS_PER_MS);
+    }
+    return 0;
+}
+
+bool EngineStartThread(void) {
+    simLock = SDL_CreateMutex();
+    SDL_SetAtomicInt(&simQuit, 0);
+    simThread = simLock ? SDL_CreateThread(SimulationThread, "Simulation", NULL) : NULL;
+    if (!simThread) {
+        SDL_Log("Couldn't start the simulation thread: %s", SDL_GetError());
+        SDL_DestroyMutex(simLock);
+        simLock = NULL;
+        return false;
+    }
+    return true;
+}
+
+void EngineStopThread(void) {
+    if (!simThread) return;
+    SDL_SetAtomicInt(&simQuit, 1);
+    SDL_WaitThread(simThread, NULL);
+    SDL_DestroyMutex(simLock);
+    simThread = NULL;
+    simLock   = NULL;
+}
+
+/* the graph, the colony and the parameters are changed only between the two, the simulation thread waits meanwhile */
+void EngineLock(void) {
+    SDL_AddAtomicInt(&simWaiting, 1);
+    SDL_LockMutex(simLock);
+    SDL_AddAtomicInt(&simWaiting, -1);
+}
+
+void EngineUnlock(void) {
+    SDL_UnlockMutex(simLock);
+}
+
+/* whether the simulation thread steps the colony, and how many times faster than real time; call it locked */
+void EngineSetRunning(bool running, int multiplier) {
+    if (running && !simRunning) accumulator = 0.0; /* no steps owed from the pause */
+    simRunning = running;
+    simSpeed   = multiplier;
+}
+
+/* the newest published snapshot, stays valid until the next call; only the rendering thread calls it */
+const struct engine_snapshot_s * EngineAcquireSnapshot(void) {
+    if (SDL_GetAtomicInt(&middleSnapshot) & SNAPSHOT_FRESH)
+        frontSnapshot = SDL_SetAtomicInt(&middleSnapshot, frontSnapshot) & ~SNAPSHOT_FRESH;
+    return &snapshots[frontSnapshot];
+}
+
+/* empties the snapshots, the colony they show is gone; the simulation thread is not publishing meanwhile */
+void FreeSnapshots(void) {
+    for (int i = 0; i < 3; i++) {
+        SDL_free(snapshots[i].positions);
+        SDL_free(snapshots[i].foraging);
+        SDL_free(snapshots[i].pheromones);
+        SDL_zero(snapshots[i]);
+    }
+    snapshotStale = true;
+}
+
+/* the ants walk whole chains, the position is found by walking the chain's edges from the source */
+static SDL_FPoint AntPosition(int i) {
+    id node = Ants.srcs[i];
+    coord_t src  = Nodes.centers[node];
+    coord_t dest = Nodes.centers[Ants.dests[i]];
+    float progress = Ants.progress[i];
+
+    id tail = Ants.edges[i];
+    if (tail != EMPTY && Ants.rates[i] > 0.0f) {
+        id c = Adjacency.chains[tail];
+        int first = Adjacency.chainOffsets[c];
+        int last  = Adjacency.chainOffsets[c + 1] - 1;
+        bool forward = Adjacency.chainEdges[last] == tail && (Adjacency.chainEdges[first] != tail || Adjacency.chainEnds[c][0] == node);
+        float distance = progress * Adjacency.chainLengths[c];
+        for (int j = 0; j <= last - first; j++) {
+            id e = Adjacency.chainEdges[forward ? first + j : last - j];
+            id next = (Edges.anodes[e] == node) ? Edges.bnodes[e] : Edges.anodes[e];
+            if (distance <= Edges.lengths[e] || j == last - first) {
+                src  = Nodes.centers[node];
+                dest = Nodes.centers[next];
+                progress = distance / Edges.lengths[e];
+                break;
+            }
+            distance -= Edges.lengths[e];
+            node = next;
+        }
+    }
+    return (SDL_FPoint) { src.x + (dest.x - src.x) * progress, src.y + (dest.y - src.y) * progress };
+}
+
+/* copies the active ants' positions and the edges' pheromones into the back snapshot and publishes it */
+static void PublishSnapshot(void) {
+    struct engine_snapshot_s * snapshot = &snapshots[backSnapshot];
+    int ants = Adjacency.offsets ? SDL_min(Ants.actives, Paths.count) : 0; /* only the ants of the started colony */
+    if (ants > snapshot->antcap) {
+        snapshot->antcap    = ants;
+        snapshot->positions = SDL_realloc(snapshot->positions, ants * sizeof(*snapshot->positions));
+        snapshot->foraging  = SDL_realloc(snapshot->foraging, ants * sizeof(*snapshot->foraging));
+        if (!snapshot->positions || !snapshot->foraging) {
+            SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+    if (Edges.size > snapshot->edgecap) {
+        snapshot->edgecap    = Edges.size;
+        snapshot->pheromones = SDL_realloc(snapshot->pheromones, Edges.size * sizeof(*snapshot->pheromones));
+        if (!snapshot->pheromones) {
+            SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < ants; i++) {
+        snapshot->positions[i] = AntPosition(i);
+        snapshot->foraging[i]  = Ants.foraging[i];
+    }
+    MaterializePheromones(); /* bring lazily evaporated edges up to date */
+    SDL_memcpy(snapshot->pheromones, Edges.pheromones, Edges.size * sizeof(*snapshot->pheromones));
+    snapshot->ticks = ticks;
+    snapshot->ants  = ants;
+    snapshot->edges = Edges.size;
+
+    backSnapshot  = SDL_SetAtomicInt(&middleSnapshot, backSnapshot | SNAPSHOT_FRESH) & ~SNAPSHOT_FRESH;
+    snapshotStale = false;
+}
+
+/* number of threads updating the ants, 0 = all logical cores; applied at the next EngineStart */
+void EngineSetThreads(int count) {
+    threadCount = count > 0 ? count : SDL_GetNumLogicalCPUCores();
+}
+
+/* the event-driven mode handles only the ants' node arrivals from a queue instead of moving every ant each step; 
+   always sequential and the ants' progress is not kept, so it is meant for headless runs; applied at the next EngineStart */
+void EngineSetEventDriven(bool events) {
+    eventDriven = events;
+}
+
+/* Food can be moved while the colony runs; a node contracted into a chain or pruned has no stop, so then the colony restarts */
+void EngineSetFood(id node) {
+    Food = node;
+    if (!Adjacency.offsets) return;
+
+    if (node != EMPTY && Adjacency.offsets[node] == Adjacency.offsets[node + 1] && Nodes.esizes[node] > 0) {
+        EngineStart();
+    } else { /* the distance heuristic follows Food */
+        ComputeFoodDistances();
+        RefreshAttractiveness();
+    }
+}
+
+/* the colony is reallocated for the new count at the next EngineStart */
+void EngineSetAntCount(int count) {
+    FreePaths();
+    Ants.count = count;
+}
+
+/* lazy evaporation decays an edge only when an ant reads or writes it, can be switched at any time */
+void EngineSetLazyEvaporation(bool lazy) {
+    MaterializePheromones();
+    LazyEvaporation = lazy;
+}
+
+/* reads the colony only, so reporting does not change a lazy-evaporation run */
+void EngineGetState(struct engine_state_s * state) {
+    state->ticks      = ticks;
+    state->time       = simTime;
+    state->count      = Ants.count;
+    state->actives    = Ants.actives;
+    state->foraging   = 0;
+    state->homing     = 0;
+    state->pheromones = 0.0f;
+
+    for (int a = 0; a < Ants.actives; a++) {
+        if (Ants.foraging[a]) state->foraging++;
+        else state->homing++;
+    }
+    for (id e = 0; e < Edges.size; e++)
+        state->pheromones += CurrentPheromone(e);
+}
+
+/* criteria set to 0 are off; the colony is converged at the first one met, the steps still run after it */
+void EngineSetConvergence(const struct convergence_s * criteria) {
+    convergence = *criteria;
+    if (convergence.interval <= 0) convergence.interval = 60;
+    converged   = false;
+    lastBest    = -1.0f;
+    staleChecks = 0;
+}
+
+bool EngineConverged(void) {
+    return converged;
+}
+
+void EngineFree(void) {
+    EngineSetMetrics(NULL, 0);
+    FreeGraph();
+}
+
+/* streams convergence metrics every interval ticks to path, JSON lines for a .jsonl file and CSV otherwise; 
+   NULL stops the stream */
+bool EngineSetMetrics(const char * path, int interval) {
+    if (metricsFile) SDL_CloseIO(metricsFile);
+    metricsFile = NULL;
+    if (!path) return true;
+
+    metricsFile = SDL_IOFromFile(path, "w");
+    if (!metricsFile) {
+        SDL_Log("Opening metrics file failed: %s\n", SDL_GetError());
+        return false;
+    }
+    metricsInterval = interval > 0 ? interval : 60;
+    metricsJson = SDL_strstr(path, ".jsonl") != NULL;
+    if (!metricsJson)
+        SDL_IOprintf(metricsFile, "ticks,time,optimum,best,mean,optimal,entropy,antspersec\n");
+    metricsWall = SDL_GetTicksNS();
+    antTicks = 0.0;
+    return true;
+}
+
+/* optimum: shortest Nest to Food route; best: shortest walk an ant has carried from Food over the whole run; 
+   mean: walk carried by the homing ants now; optimal: percent of the active ants carrying an optimal walk home; 
+   entropy: of the pheromone share of the edges in use, 1 = uniform and 0 = all on one edge; 
+   only reads the colony, so sampling it does not change the run */
+void EngineGetMetrics(struct engine_metrics_s * m) {
+    m->optimum = (Nest != EMPTY && Adjacency.distances) ? Adjacency.distances[Nest] : -1.0f;
+
+    int homing = 0, optimal = 0;
+    double sum = 0.0;
+    for (int a = 0; a < Ants.actives; a++) {
+        if (Ants.foraging[a]) continue;
+        float length = Ants.pathlengths[a];
+        homing++;
+        sum += length;
+        if (m->optimum > 0.0f && length <= m->optimum * 1.001f) optimal++;
+    }
+    m->mean = homing > 0 ? sum / homing : -1.0;
+    m->optimal = Ants.actives > 0 ? 100.0 * optimal / Ants.actives : 0.0;
+    m->best = BestWalk();
+
+    int live = 0;
+    double total = 0.0;
+    m->entropy = 0.0;
+    for (id e = 0; e < Edges.size; e++) {
+        if (Adjacency.chains[e] == EMPTY) continue; /* pruned */
+        total += CurrentPheromone(e);
+        live++;
+    }
+    for (id e = 0; e < Edges.size && total > 0.0; e++) {
+        if (Adjacency.chains[e] == EMPTY) continue;
+        double share = CurrentPheromone(e) / total;
+        if (share > 0.0) m->entropy -= share * SDL_log(share);
+    }
+    if (live > 1) m->entropy /= SDL_log(live);
+}
+
+/* mean lambda-branching factor over the stops on a trail: slots with a real share of the node's pheromone, 
+   less the way back at stops other than the Nest (a trail's end counts 1); tends to 1 as the trails settle; 
+   stops where every edge is at the floor are left out, before any trail there is no factor (-1) */
+static double BranchingFactor(void) {
+    int stops = 0;
+    double branches = 0.0;
+    for (id n = 0; n < Nodes.size; n++) {
+        bool nest = n == Nest;
+        int first = Adjacency.offsets[n], last = Adjacency.offsets[n + 1];
+        if (last - first < (nest ? 2 : 3)) continue; /* no choice */
+
+        float min = CurrentPheromone(Adjacency.edges[first]), max = min;
+        for (int k = first + 1; k < last; k++) {
+            float p = CurrentPheromone(Adjacency.edges[k]);
+            if (p < min) min = p;
+            if (p > max) max = p;
+        }
+        if (max <= min) continue; /* no trail */
+
+        float limit = min + LAMBDA_BRANCHING * (max - min);
+        int count = 0;
+        for (int k = first; k < last; k++)
+            if (CurrentPheromone(Adjacency.edges[k]) >= limit) count++;
+        branches += (nest || count < 2) ? count : count - 1;
+        stops++;
+    }
+    return stops > 0 ? branches / stops : -1.0;
+}
+
+/* reads the colony only, so the checks stop a run at the same tick whether or not metrics are streamed; 
+   the patience counts on the best walk taken at the Food arrivals, not on what a sample saw */
+static void CheckConvergence(void) {
+    if (convergence.entropy <= 0.0f && convergence.patience <= 0 && convergence.branching <= 0.0f) return;
+    if (Ants.actives < Ants.count) return; /* not settled before every ant is out */
+
+    float best = BestWalk();
+    if (best >= 0.0f && (lastBest < 0.0f || best < lastBest)) {
+        lastBest = best;
+        staleChecks = 0;
+    } else if (best >= 0.0f) {
+        staleChecks++;
+    }
+
+    struct engine_metrics_s m;
+    if (convergence.entropy > 0.0f) EngineGetMetrics(&m);
+
+    if (convergence.entropy > 0.0f && m.entropy < convergence.entropy) {
+        SDL_Log("Converged at tick %" SDL_PRIu64 ": pheromone entropy %.4f.\n", ticks, m.entropy);
+        converged = true;
+    } else if (convergence.patience > 0 && staleChecks >= convergence.patience) {
+        SDL_Log("Converged at tick %" SDL_PRIu64 ": best walk %.2f not improved in %d checks.\n", ticks, best, staleChecks);
+        converged = true;
+    } else if (convergence.branching > 0.0f) {
+        double branching = BranchingFactor();
+        if (branching >= 0.0 && branching < convergence.branching) {
+            SDL_Log("Converged at tick %" SDL_PRIu64 ": branching factor %.3f.\n", ticks, branching);
+            converged = true;
+        }
+    }
+}
+
+/* antspersec: active ants times ticks simulated per wall clock second */
+static void EmitMetrics(void) {
+    struct engine_metrics_s m;
+    EngineGetMetrics(&m);
+
+    Uint64 now = SDL_GetTicksNS();
+    double wallSecs = (now - metricsWall) / 1e9;
+    double antsPerSec = wallSecs > 0.0 ? antTicks / wallSecs : 0.0;
+    metricsWall = now;
+    antTicks = 0.0;
+
+    if (metricsJson) {
+        SDL_IOprintf(metricsFile, "{\"ticks\":%" SDL_PRIu64 ",\"time\":%.3f,\"optimum\":%.2f,\"best\":%.2f,\"mean\":%.2f,"
+                                  "\"optimal\":%.2f,\"entropy\":%.4f,\"antspersec\":%.0f}\n",
+                     ticks, simTime, m.optimum, m.best, m.mean, m.optimal, m.entropy, antsPerSec);
+    } else {
+        SDL_IOprintf(metricsFile, "%" SDL_PRIu64 ",%.3f,%.2f,%.2f,%.2f,%.2f,%.4f,%.0f\n",
+                     ticks, simTime, m.optimum, m.best, m.mean, m.optimal, m.entropy, antsPerSec);
+    }
+}
+
+/* the colony needs a Nest with an exit, a path to Food if there is one, and at least one ant (Food is optional) */
+bool ValidateGraph(void) {
+    bool validgraph = true;
+    if (Nest == EMPTY || Nest >= Nodes.size) {
+        SDL_Log("Set the Nest nodes (Food is optional).\n");
+        validgraph = false;
+    } else if (Nodes.esizes[Nest] < 1) {
+        SDL_Log("Nest has no exit.\n");
+        validgraph = false;
+    }
+
+    if (validgraph && !FoodReachable()) {
+        SDL_Log("Food is not reachable from the Nest.\n");
+        validgraph = false;
+    }
+
+    if (Ants.count < 1 || Ants.count > MAX_ANTS) {
+        SDL_Log("Invalid ant count.\n");
+        validgraph = false;
+    }
+    return validgraph;
+}
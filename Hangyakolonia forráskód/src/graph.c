@@ -0,0 +1,1452 @@
+#include <global.h>
+#include <stdlib.h>
+
+/* globals */
+struct nodes_s Nodes;
+struct grids_s Grids;
+struct edges_s Edges;
+struct ants_s  Ants;
+struct paths_s Paths;
+struct adjacency_s Adjacency;
+id Nest;
+id Food;
+Uint32 GraphSavedEvent = 0;
+Uint32 GraphLoadedEvent = 0;
+
+/* binary graph file: this header, then x, y (int32) per node, anode, bnode (uint32, anode < bnode) per edge 
+   and length (float) per edge, each as one flat array read straight into the graph; 
+   stored in the writer's byte order, byteorder tells a file from a host of the other order */
+#define GRAPH_MAGIC         "HANGYAGR"
+#define GRAPH_VERSION       1
+#define GRAPH_BYTEORDER     0x01020304u
+
+struct graph_header_s {
+    char         magic[8];
+    uint32_t     version;
+    uint32_t     byteorder;
+    uint32_t     nodes;
+    uint32_t     edges;
+    uint32_t     nest;     /* 0xFFFFFFFF = none */
+    uint32_t     food;
+    int32_t      ants;
+    float        params[9]; /* EvaporationRate, EvaporationInterval, PheromoneMin, PheromoneMax, Alpha, Beta, Q, AntSpeed, Weight */
+};
+
+/* a graph read off to the side of the one in use, InstallGraph swaps it in */
+struct graph_s {
+    struct nodes_s nodes;
+    struct edges_s edges;
+    struct grids_s grids;
+    id             nest;
+    id             food;
+    int            ants;
+    float          params[9]; /* as in the binary header */
+    bool           weight;    /* params[8] is set, text files have no Weight */
+};
+
+SDL_COMPILE_TIME_ASSERT(coord_size, sizeof(coord_t) == 2 * sizeof(int32_t));
+
+static bool AddToGrid(const struct nodes_s *, struct grids_s *, int, int);
+static id FindNodeInArea(const struct nodes_s *, const struct grids_s *, int, int, int);
+static int64_t GrowCapacity(int64_t);
+static float * ReallocVector(float *, int, int);
+static void ReserveNodes(struct nodes_s *, int64_t);
+static void ReserveEdges(struct edges_s *, int64_t);
+static void SetEdgeGeometry(const struct nodes_s *, struct edges_s *, id);
+static void AppendNodeEdge(struct nodes_s *, id, id);
+static bool LoadGraphBinary(struct graph_s *, SDL_IOStream *, const struct graph_header_s *);
+static const char * LoadGraphText(struct graph_s *, const char *, const char *);
+static bool ReportProgress(int);
+
+/**********************************************/
+/********* Memory handling functions **********/
+/**********************************************/
+/* Graph's nodes */
+static void CreateNodes(struct nodes_s * nodes) {
+    int cap = 32;
+    nodes->capacity     = cap;
+    nodes->size         = 0;
+    nodes->centers      = SDL_malloc(cap * sizeof(*nodes->centers));
+    nodes->edges        = SDL_malloc(cap * sizeof(*nodes->edges));
+    nodes->ecapacities  = SDL_malloc(cap * sizeof(*nodes->ecapacities));
+    nodes->esizes       = SDL_malloc(cap * sizeof(*nodes->esizes));
+    if (!nodes->centers || !nodes->edges || !nodes->ecapacities || !nodes->esizes) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    int edgecap = 8;
+    for (int i = 0; i < cap; i++) {
+        nodes->ecapacities[i]   = edgecap;
+        nodes->esizes[i]        = 0;
+        nodes->edges[i]         = SDL_malloc(edgecap * sizeof(*nodes->edges[i]));
+        if (!nodes->edges[i]) {
+            SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+}
+
+static void DestroyNodes(struct nodes_s * nodes) {
+    for (id i = 0; i < nodes->capacity; SDL_free(nodes->edges[i++]));
+    SDL_free(nodes->centers);
+    SDL_free(nodes->edges);
+    SDL_free(nodes->ecapacities);
+    SDL_free(nodes->esizes);
+}
+
+void InitializeNodes(void) {
+    CreateNodes(&Nodes);
+}
+
+void FreeNodes(void) {
+    DestroyNodes(&Nodes);
+}
+
+void AddNewNode(int x, int y) {
+    int min_xy = Grids.pxsize + CIRCLE_RAD;
+    int max_x  = WIN_WIDTH  - Grids.pxsize - CIRCLE_RAD;
+    int max_y  = WIN_HEIGHT - Grids.pxsize - CIRCLE_RAD;
+    x = x < min_xy ? min_xy : x;
+    x = x > max_x  ? max_x  : x;
+    y = y < min_xy ? min_xy : y;
+    y = y > max_y  ? max_y  : y;
+
+    int dsquared = CIRCLE_SIZE * CIRCLE_SIZE * 4;
+    if (SearchNodeInArea(x, y, dsquared) != EMPTY) {
+        SDL_Log("Too close to another circle.\n");
+        return;
+    }
+
+    id idx = Nodes.size;
+    if (idx >= Nodes.capacity) {
+        int64_t cap = GrowCapacity(Nodes.capacity);
+        if (!cap) {
+            SDL_Log("Too many nodes to allocate!\n");
+            return;
+        }
+        ReserveNodes(&Nodes, cap);
+    }
+
+    if (AddToGrid(&Nodes, &Grids, x, y)) {
+        Nodes.centers[idx] = (coord_t) { x, y };
+        Nodes.size++;
+    }
+}
+
+/* grows the node arrays to cap, every new node gets an empty edge list */
+static void ReserveNodes(struct nodes_s * nodes, int64_t cap) {
+    if (cap <= nodes->capacity) return;
+    id idx = nodes->capacity;
+    nodes->capacity = cap;
+    nodes->centers = SDL_realloc(nodes->centers, cap * sizeof(*nodes->centers));
+    nodes->esizes  = SDL_realloc(nodes->esizes, cap * sizeof(*nodes->esizes));
+    nodes->ecapacities = SDL_realloc(nodes->ecapacities, cap * sizeof(*nodes->ecapacities));
+    nodes->edges       = SDL_realloc(nodes->edges, cap * sizeof(*nodes->edges));
+    if (!nodes->centers || !nodes->esizes || !nodes->ecapacities || !nodes->edges) {
+        SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    
+    int edgecap = 8;
+    for (int64_t i = idx; i < cap; i++) {
+        nodes->ecapacities[i] = edgecap;
+        nodes->esizes[i]      = 0;
+        nodes->edges[i]       = SDL_malloc(edgecap * sizeof(*nodes->edges[i])); 
+        if (!nodes->edges[i]) {
+            SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+}
+
+/* Grids for node placement */
+static void CreateGrids(struct grids_s * grids) {
+    int size = CIRCLE_SIZE * 2;
+    grids->pxsize   = size;
+    grids->width    = (WIN_WIDTH  + size - 1) / size;
+    grids->height   = (WIN_HEIGHT + size - 1) / size;
+    grids->capacity = grids->width * grids->height;
+    grids->nodes    = SDL_malloc(grids->capacity * sizeof(*grids->nodes));
+    if (!grids->nodes) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    SDL_memset(grids->nodes, 0xFF, grids->capacity * sizeof(*grids->nodes));
+}
+
+static void DestroyGrids(struct grids_s * grids) {
+    SDL_free(grids->nodes);
+}
+
+void InitializeGrids(void) {
+    CreateGrids(&Grids);
+}
+
+void FreeGrids(void) {
+    DestroyGrids(&Grids);
+}
+
+/* Graph's edges */
+static void CreateEdges(struct edges_s * edges) {
+    int cap = 32;
+    edges->color        = (SDL_FColor) { 0.f, 200.f, 0.f, 255.f };
+    edges->capacity     = cap;
+    edges->size         = 0;
+    edges->verts        = SDL_malloc(cap * 4 * sizeof(*edges->verts));
+    edges->vidxs        = SDL_malloc(cap * 6 * sizeof(*edges->vidxs));
+    edges->widths       = SDL_malloc(cap * sizeof(*edges->widths));
+    edges->lengths      = SDL_malloc(cap * sizeof(*edges->lengths));
+    edges->pheromones   = ReallocVector(NULL, 0, cap);
+    edges->heuristics   = SDL_malloc(cap * sizeof(*edges->heuristics));
+    edges->attractiveness = SDL_malloc(cap * sizeof(*edges->attractiveness));
+    edges->epochs       = SDL_malloc(cap * sizeof(*edges->epochs));
+    edges->epoch        = 0;
+    edges->anodes       = SDL_malloc(cap * sizeof(*edges->anodes));
+    edges->bnodes       = SDL_malloc(cap * sizeof(*edges->bnodes));
+    if (!edges->verts || !edges->vidxs || !edges->widths || !edges->lengths || 
+        !edges->pheromones || !edges->heuristics || !edges->attractiveness || !edges->epochs || !edges->anodes || !edges->bnodes) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+}
+
+void AddNewEdge(id a, id b) {
+    if (a >= Nodes.size || b >= Nodes.size) {
+        SDL_Log("Invalid nodes to add an edge!\n");
+        return;
+    }
+
+    if (a == b) {
+        SDL_Log("Same node selected.\n");
+        return;
+    }
+
+    /* nodes saved in order */
+    if (a > b) {
+        id temp = a;
+        a = b;
+        b = temp;
+    }
+
+    /* checking at one node must be enough */
+    for (id e = 0; e < Nodes.esizes[a]; e++) {
+        id edge = Nodes.edges[a][e];
+        if (Edges.bnodes[edge] == b) {
+            SDL_Log("Edge already exists.\n");
+            return;
+        }
+    }
+
+    /* Adding the edge to the nodes */
+    AppendNodeEdge(&Nodes, a, Edges.size);
+    AppendNodeEdge(&Nodes, b, Edges.size);
+    
+    /* Adding the edge to the edges */
+    id edge = Edges.size;
+    if (edge >= Edges.capacity) {
+        int64_t cap = GrowCapacity(Edges.capacity);
+        if (!cap) {
+            SDL_Log("Too many edges to allocate!\n");
+            exit(1);
+        }
+        ReserveEdges(&Edges, cap);
+    }
+
+    float dX = Nodes.centers[b].x - Nodes.centers[a].x;
+    float dY = Nodes.centers[b].y - Nodes.centers[a].y;
+    Edges.anodes[edge]     = a;
+    Edges.bnodes[edge]     = b;
+    Edges.lengths[edge]    = SDL_sqrt(dX * dX + dY * dY);
+    SetEdgeGeometry(&Nodes, &Edges, edge);
+    Edges.pheromones[edge] = PheromoneMin;
+    Edges.epochs[edge]     = Edges.epoch;
+    Edges.size++;
+    SDL_Log("New Edge added. Edge[%d]. Anode=%d Bnode=%d Length=%.2f\n", edge, Edges.anodes[edge], Edges.bnodes[edge], Edges.lengths[edge]);
+}
+
+/* adds edge to the node's edge list, growing it when full */
+static void AppendNodeEdge(struct nodes_s * nodes, id node, id edge) {
+    id esize = nodes->esizes[node];
+    if (esize >= nodes->ecapacities[node]) {
+        int64_t ecap = GrowCapacity(nodes->ecapacities[node]);
+        if (!ecap) {
+            SDL_Log("Too many edges to allocate!\n");
+            exit(1);
+        }
+        nodes->ecapacities[node] = ecap;
+        nodes->edges[node] = SDL_realloc(nodes->edges[node], ecap * sizeof(*nodes->edges[node]));
+        if (!nodes->edges[node]) {
+            SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+            exit(1);
+        }
+    }
+    nodes->edges[node][esize] = edge;
+    nodes->esizes[node]++;
+}
+
+/* grows the edge arrays to cap */
+static void ReserveEdges(struct edges_s * edges, int64_t cap) {
+    if (cap <= edges->capacity) return;
+    edges->capacity   = cap;
+    edges->verts      = SDL_realloc(edges->verts, cap * 4 * sizeof(*edges->verts));
+    edges->vidxs      = SDL_realloc(edges->vidxs, cap * 6 * sizeof(*edges->vidxs));
+    edges->widths     = SDL_realloc(edges->widths, cap * sizeof(*edges->widths));
+    edges->anodes     = SDL_realloc(edges->anodes, cap * sizeof(*edges->anodes));
+    edges->bnodes     = SDL_realloc(edges->bnodes, cap * sizeof(*edges->bnodes));
+    edges->lengths    = SDL_realloc(edges->lengths, cap * sizeof(*edges->lengths));
+    edges->pheromones = ReallocVector(edges->pheromones, edges->size, cap);
+    edges->heuristics = SDL_realloc(edges->heuristics, cap * sizeof(*edges->heuristics));
+    edges->attractiveness = SDL_realloc(edges->attractiveness, cap * sizeof(*edges->attractiveness));
+    edges->epochs     = SDL_realloc(edges->epochs, cap * sizeof(*edges->epochs));
+    if (!edges->verts || !edges->vidxs || !edges->widths || !edges->anodes || !edges->bnodes || !edges->lengths || 
+        !edges->pheromones || !edges->heuristics || !edges->attractiveness || !edges->epochs) {
+        SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+}
+
+/* width and the render quad of the edge between its anode and bnode, its length is set beforehand */
+static void SetEdgeGeometry(const struct nodes_s * nodes, struct edges_s * edges, id edge) {
+    id a = edges->anodes[edge];
+    id b = edges->bnodes[edge];
+    int aX = nodes->centers[a].x;
+    int aY = nodes->centers[a].y;
+    int bX = nodes->centers[b].x;
+    int bY = nodes->centers[b].y;
+    float dX = bX - aX;
+    float dY = bY - aY;
+    float length = edges->lengths[edge];
+    float pX = (-dY / length) * (MIN_EDGE_WIDTH / 2);
+    float pY = ( dX / length) * (MIN_EDGE_WIDTH / 2);
+    
+    SDL_Vertex v0 = { .position = { aX + pX, aY + pY }, .color = edges->color };
+    SDL_Vertex v1 = { .position = { bX + pX, bY + pY }, .color = edges->color };
+    SDL_Vertex v2 = { .position = { bX - pX, bY - pY }, .color = edges->color };
+    SDL_Vertex v3 = { .position = { aX - pX, aY - pY }, .color = edges->color };    
+
+    int vstart = edge * 4;
+    edges->verts[vstart + 0] = v0;
+    edges->verts[vstart + 1] = v1;
+    edges->verts[vstart + 2] = v2;
+    edges->verts[vstart + 3] = v3;   
+    
+    edges->vidxs[edge * 6 + 0] = vstart + 0;
+    edges->vidxs[edge * 6 + 1] = vstart + 1;
+    edges->vidxs[edge * 6 + 2] = vstart + 2;
+    edges->vidxs[edge * 6 + 3] = vstart + 0;
+    edges->vidxs[edge * 6 + 4] = vstart + 2;
+    edges->vidxs[edge * 6 + 5] = vstart + 3;
+    
+    edges->widths[edge]     = MIN_EDGE_WIDTH;
+}
+
+static void DestroyEdges(struct edges_s * edges) {
+    SDL_free(edges->verts);
+    SDL_free(edges->vidxs);
+    SDL_free(edges->widths);
+    SDL_free(edges->lengths);
+    SDL_aligned_free(edges->pheromones);
+    SDL_free(edges->heuristics);
+    SDL_free(edges->attractiveness);
+    SDL_free(edges->epochs);
+    SDL_free(edges->anodes);
+    SDL_free(edges->bnodes);
+}
+
+void InitializeEdges(void) {
+    CreateEdges(&Edges);
+}
+
+void FreeEdges(void) {
+    DestroyEdges(&Edges);
+}
+
+/* Ants */
+void InitializeAnts() { 
+    //Ants.count initialized beforehand in Initialize() function
+    Ants.actives = 0;
+    int count = Ants.count;
+    Ants.progress    = SDL_malloc(count * sizeof(*Ants.progress));
+    Ants.rates       = SDL_malloc(count * sizeof(*Ants.rates));
+    Ants.pathlengths = SDL_malloc(count * sizeof(*Ants.pathlengths));
+    Ants.TTLs        = SDL_malloc(count * sizeof(*Ants.TTLs));
+    Ants.srcs        = SDL_malloc(count * sizeof(*Ants.srcs));
+    Ants.dests       = SDL_malloc(count * sizeof(*Ants.dests));
+    Ants.edges       = SDL_malloc(count * sizeof(*Ants.edges));
+    Ants.pathidxs    = SDL_malloc(count * sizeof(*Ants.pathidxs));
+    Ants.foraging    = SDL_malloc(count * sizeof(*Ants.foraging));
+    if (!Ants.progress || !Ants.rates || !Ants.pathlengths || !Ants.TTLs || !Ants.srcs || 
+        !Ants.dests || !Ants.edges || !Ants.pathidxs || !Ants.foraging) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    for (int a = 0; a < Ants.count; a++) ResetBaseAntParams(a);
+}
+
+void FreeAnts(void) {
+    SDL_free(Ants.progress);
+    SDL_free(Ants.rates);
+    SDL_free(Ants.pathlengths);
+    SDL_free(Ants.TTLs);
+    SDL_free(Ants.srcs);
+    SDL_free(Ants.dests);
+    SDL_free(Ants.edges);
+    SDL_free(Ants.pathidxs);
+    SDL_free(Ants.foraging);
+    Ants.progress    = NULL;
+    Ants.rates       = NULL;
+    Ants.pathlengths = NULL;
+    Ants.TTLs        = NULL;
+    Ants.srcs        = NULL;
+    Ants.dests       = NULL;
+    Ants.edges       = NULL;
+    Ants.pathidxs    = NULL;
+    Ants.foraging    = NULL;
+}
+
+/* Paths - runs only after the graph has been created */
+void InitializePaths(void) {
+    int count = Ants.count;
+    Paths.pool        = SDL_malloc((size_t)count * PATH_CHUNK * sizeof(*Paths.pool));
+    Paths.steps       = SDL_malloc(count * sizeof(*Paths.steps));
+    Paths.capacities  = SDL_malloc(count * sizeof(*Paths.capacities));
+    Paths.vpool       = SDL_malloc((size_t)count * PATH_CHUNK * 2 * sizeof(*Paths.vpool));
+    Paths.visits      = SDL_malloc(count * sizeof(*Paths.visits));
+    Paths.vcapacities = SDL_malloc(count * sizeof(*Paths.vcapacities));
+    Paths.vsizes      = SDL_malloc(count * sizeof(*Paths.vsizes));
+    if (!Paths.pool || !Paths.steps || !Paths.capacities || 
+        !Paths.vpool || !Paths.visits || !Paths.vcapacities || !Paths.vsizes) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    SDL_memset(Paths.vpool, 0xFF, (size_t)count * PATH_CHUNK * 2 * sizeof(*Paths.vpool));
+    Paths.count = count;
+
+    for (int a = 0; a < count; a++) {
+        Paths.steps[a]       = Paths.pool + (size_t)a * PATH_CHUNK;
+        Paths.capacities[a]  = PATH_CHUNK;
+        Paths.visits[a]      = Paths.vpool + (size_t)a * PATH_CHUNK * 2;
+        Paths.vcapacities[a] = PATH_CHUNK * 2;
+        Paths.vsizes[a]      = 0;
+    }
+}
+
+/* doubles the ant's path, a walk without loops never exceeds the node count; safe from the workers */
+void GrowPath(id a) {
+    int64_t cap = (int64_t)Paths.capacities[a] * 2;
+    if (cap > Nodes.size) cap = Nodes.size;
+
+    struct step_s * steps;
+    if (Paths.capacities[a] == PATH_CHUNK) { /* leaving the pool */
+        steps = SDL_malloc(cap * sizeof(*steps));
+        if (steps) SDL_memcpy(steps, Paths.steps[a], PATH_CHUNK * sizeof(*steps));
+    } else {
+        steps = SDL_realloc(Paths.steps[a], cap * sizeof(*steps));
+    }
+    if (!steps) {
+        SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    Paths.steps[a]      = steps;
+    Paths.capacities[a] = cap;
+}
+
+/* doubles the ant's visit table, the table is left empty for the caller to refill; safe from the workers */
+void GrowVisits(id a) {
+    uint32_t cap = Paths.vcapacities[a] * 2;
+    id * visits = SDL_malloc(cap * sizeof(*visits));
+    if (!visits) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    SDL_memset(visits, 0xFF, cap * sizeof(*visits));
+
+    if (Paths.vcapacities[a] > PATH_CHUNK * 2) SDL_free(Paths.visits[a]); /* not in the pool */
+    Paths.visits[a]      = visits;
+    Paths.vcapacities[a] = cap;
+    Paths.vsizes[a]      = 0;
+}
+
+void FreePaths(void) {
+    for (int a = 0; a < Paths.count; a++) {
+        if (Paths.capacities[a] > PATH_CHUNK) SDL_free(Paths.steps[a]);
+        if (Paths.vcapacities[a] > PATH_CHUNK * 2) SDL_free(Paths.visits[a]);
+    }
+    SDL_free(Paths.pool);
+    SDL_free(Paths.steps);
+    SDL_free(Paths.capacities);
+    SDL_free(Paths.vpool);
+    SDL_free(Paths.visits);
+    SDL_free(Paths.vcapacities);
+    SDL_free(Paths.vsizes);
+    Paths.pool        = NULL;
+    Paths.steps       = NULL;
+    Paths.capacities  = NULL;
+    Paths.vpool       = NULL;
+    Paths.visits      = NULL;
+    Paths.vcapacities = NULL;
+    Paths.vsizes      = NULL;
+    Paths.count       = 0;
+}
+
+/* degree 2 nodes are only passed through, the ants stop at Nest, Food and the junctions; degrees after pruning */
+bool IsChainNode(id n) {
+    return Adjacency.degrees[n] == 2 && n != Nest && n != Food;
+}
+
+/* the edge at the other end of the edge's chain */
+id OtherChainEnd(id edge) {
+    id c = Adjacency.chains[edge];
+    id first = Adjacency.chainEdges[Adjacency.chainOffsets[c]];
+    id last  = Adjacency.chainEdges[Adjacency.chainOffsets[c + 1] - 1];
+    return edge == first ? last : first;
+}
+
+/* breadth first search from start over the whole graph, queue holds Nodes.size ids */
+static void MarkComponent(id start, bool * reached, id * queue) {
+    SDL_memset(reached, 0, Nodes.size * sizeof(*reached));
+    if (start == EMPTY || start >= Nodes.size) return;
+
+    int head = 0, tail = 0;
+    reached[start] = true;
+    queue[tail++] = start;
+    while (head < tail) {
+        id n = queue[head++];
+        for (id i = 0; i < Nodes.esizes[n]; i++) {
+            id e = Nodes.edges[n][i];
+            id other = (Edges.anodes[e] == n) ? Edges.bnodes[e] : Edges.anodes[e];
+            if (!reached[other]) {
+                reached[other] = true;
+                queue[tail++] = other;
+            }
+        }
+    }
+}
+
+/* whether the ants can find Food at all, true without Food */
+bool FoodReachable(void) {
+    if (Food == EMPTY) return true;
+
+    bool * reached = SDL_malloc((Nodes.size + 1) * sizeof(*reached));
+    id * queue = SDL_malloc((Nodes.size + 1) * sizeof(*queue));
+    if (!reached || !queue) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    MarkComponent(Nest, reached, queue);
+    bool reachable = Food < Nodes.size && reached[Food];
+    SDL_free(reached);
+    SDL_free(queue);
+    return reachable;
+}
+
+/* peels the dead ends in queue[0..tail) leaf by leaf, so whole dead end branches go */
+static void PeelDeadEnds(bool * pruned, id * queue, int tail, int * nodes, int * edges) {
+    for (int head = 0; head < tail; head++) {
+        id n = queue[head];
+        for (id i = 0; i < Nodes.esizes[n]; i++) {
+            id e = Nodes.edges[n][i];
+            if (pruned[e]) continue;
+            pruned[e] = true;
+            (*edges)++;
+
+            id other = (Edges.anodes[e] == n) ? Edges.bnodes[e] : Edges.anodes[e];
+            if (--Adjacency.degrees[other] == 1 && other != Nest && other != Food) queue[tail++] = other;
+        }
+        Adjacency.degrees[n] = 0;
+        (*nodes)++;
+    }
+}
+
+/* a ring leaves a stop and rejoins it through chain nodes only: no walk from Nest to Food uses it, 
+   an ant entering it only comes back where it started; the stops left as dead ends go to queue, returns the rings */
+static int PruneRings(bool * pruned, id * queue, int * tail, int * nodes, int * edges) {
+    int rings = 0;
+    for (id n = 0; n < Nodes.size; n++) {
+        if (Adjacency.degrees[n] == 0 || IsChainNode(n)) continue;
+        for (id i = 0; i < Nodes.esizes[n]; i++) {
+            id e = Nodes.edges[n][i];
+            if (pruned[e]) continue;
+
+            id node = n, edge = e;
+            for (;;) {
+                node = (Edges.anodes[edge] == node) ? Edges.bnodes[edge] : Edges.anodes[edge];
+                if (!IsChainNode(node)) break;
+                id j = 0; /* the chain node's other unpruned edge */
+                while (Nodes.edges[node][j] == edge || pruned[Nodes.edges[node][j]]) j++;
+                edge = Nodes.edges[node][j];
+            }
+            if (node != n) continue;
+
+            for (node = n, edge = e;;) {
+                pruned[edge] = true;
+                (*edges)++;
+                node = (Edges.anodes[edge] == node) ? Edges.bnodes[edge] : Edges.anodes[edge];
+                if (node == n) break;
+                id j = 0;
+                while (pruned[Nodes.edges[node][j]]) j++;
+                edge = Nodes.edges[node][j];
+                Adjacency.degrees[node] = 0;
+                (*nodes)++;
+            }
+            Adjacency.degrees[n] -= 2;
+            if (Adjacency.degrees[n] == 1 && n != Nest && n != Food) queue[(*tail)++] = n;
+            rings++;
+        }
+    }
+    return rings;
+}
+
+/* masks what the ants could only waste their TTL on: parts not connected to the Nest, dead ends and rings; 
+   pruning one can leave another behind, so they go until none is left; Nest and Food are spared, and without 
+   a reachable Food the dead ends stay so the Nest keeps its exits; fills Adjacency.degrees */
+static void PruneGraph(bool * pruned) {
+    bool * reached = SDL_malloc((Nodes.size + 1) * sizeof(*reached));
+    id * queue = SDL_malloc((Nodes.size + 1) * sizeof(*queue));
+    if (!reached || !queue) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    MarkComponent(Nest, reached, queue);
+    for (id e = 0; e < Edges.size; e++) pruned[e] = !reached[Edges.anodes[e]];
+
+    bool peel = Food != EMPTY && Food < Nodes.size && reached[Food];
+    int tail = 0;
+    for (id n = 0; n < Nodes.size; n++) {
+        Adjacency.degrees[n] = reached[n] ? Nodes.esizes[n] : 0;
+        if (peel && Adjacency.degrees[n] == 1 && n != Nest && n != Food) queue[tail++] = n;
+    }
+
+    int nodes = 0, edges = 0;
+    if (peel) {
+        do {
+            PeelDeadEnds(pruned, queue, tail, &nodes, &edges);
+            tail = 0;
+        } while (PruneRings(pruned, queue, &tail, &nodes, &edges) > 0);
+    }
+
+    for (id n = 0; n < Nodes.size; n++) if (!reached[n]) nodes++;
+    for (id e = 0; e < Edges.size; e++) if (!reached[Edges.anodes[e]]) edges++;
+    if (nodes > 0) SDL_Log("Pruned %d nodes and %d edges the ants can not use.\n", nodes, edges);
+
+    SDL_free(reached);
+    SDL_free(queue);
+}
+
+/* Adjacency - runs only after the graph has been created, the ants read it instead of Nodes.edges */
+void InitializeAdjacency(void) {
+    int size = Edges.size * 2;
+    Adjacency.size         = size;
+    Adjacency.offsets      = SDL_malloc((Nodes.size + 1) * sizeof(*Adjacency.offsets));
+    Adjacency.edges        = SDL_malloc((size + 1) * sizeof(*Adjacency.edges));
+    Adjacency.tails        = SDL_malloc((size + 1) * sizeof(*Adjacency.tails));
+    Adjacency.others       = SDL_malloc((size + 1) * sizeof(*Adjacency.others));
+    Adjacency.lengths      = SDL_malloc((size + 1) * sizeof(*Adjacency.lengths));
+    Adjacency.prefix       = SDL_malloc((size + 1) * sizeof(*Adjacency.prefix));
+    Adjacency.dirty        = SDL_malloc((Nodes.size + 1) * sizeof(*Adjacency.dirty));
+    Adjacency.hubs         = SDL_malloc((Nodes.size + 1) * sizeof(*Adjacency.hubs));
+    Adjacency.chains       = SDL_malloc((Edges.size + 1) * sizeof(*Adjacency.chains));
+    Adjacency.chainOffsets = SDL_malloc((Edges.size + 1) * sizeof(*Adjacency.chainOffsets));
+    Adjacency.chainEdges   = SDL_malloc((Edges.size + 1) * sizeof(*Adjacency.chainEdges));
+    Adjacency.chainEnds    = SDL_malloc((Edges.size + 1) * sizeof(*Adjacency.chainEnds));
+    Adjacency.chainLengths = SDL_malloc((Edges.size + 1) * sizeof(*Adjacency.chainLengths));
+    Adjacency.degrees      = SDL_malloc((Nodes.size + 1) * sizeof(*Adjacency.degrees));
+    Adjacency.distances    = SDL_malloc((Nodes.size + 1) * sizeof(*Adjacency.distances));
+    Adjacency.biases       = SDL_malloc((size + 1) * sizeof(*Adjacency.biases));
+    bool * pruned          = SDL_malloc((Edges.size + 1) * sizeof(*pruned));
+    if (!Adjacency.offsets || !Adjacency.edges || !Adjacency.tails || !Adjacency.others || !Adjacency.lengths || 
+        !Adjacency.prefix || !Adjacency.dirty || !Adjacency.hubs || !Adjacency.chains || !Adjacency.chainOffsets || 
+        !Adjacency.chainEdges || !Adjacency.chainEnds || !Adjacency.chainLengths || !Adjacency.degrees || 
+        !Adjacency.distances || !Adjacency.biases || !pruned) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    PruneGraph(pruned);
+
+    /* chains - walked from every stop through the degree 2 nodes to the next stop */
+    for (id e = 0; e < Edges.size; e++) Adjacency.chains[e] = EMPTY;
+    int c = 0, ce = 0;
+    for (id n = 0; n < Nodes.size; n++) {
+        if (IsChainNode(n)) continue;
+        for (id i = 0; i < Nodes.esizes[n]; i++) {
+            id e = Nodes.edges[n][i];
+            if (pruned[e] || Adjacency.chains[e] != EMPTY) continue; /* pruned or walked from its other end */
+
+            Adjacency.chainOffsets[c] = ce;
+            Adjacency.chainEnds[c][0] = n;
+            Adjacency.chainLengths[c] = 0.0f;
+            id node = n;
+            for (;;) {
+                Adjacency.chains[e] = c;
+                Adjacency.chainEdges[ce++] = e;
+                Adjacency.chainLengths[c] += Edges.lengths[e];
+                node = (Edges.anodes[e] == node) ? Edges.bnodes[e] : Edges.anodes[e];
+                if (!IsChainNode(node)) break;
+                id i = 0; /* the chain node's other unpruned edge */
+                while (Nodes.edges[node][i] == e || pruned[Nodes.edges[node][i]]) i++;
+                e = Nodes.edges[node][i];
+            }
+            Adjacency.chainEnds[c][1] = node;
+            c++;
+        }
+    }
+    Adjacency.chainOffsets[c] = ce;
+    Adjacency.chaincount = c;
+
+    /* slots - only the stops have them, in Nodes.edges order */
+    int k = 0;
+    Adjacency.hubcount = 0;
+    for (id n = 0; n < Nodes.size; n++) {
+        Adjacency.offsets[n] = k;
+        Adjacency.dirty[n] = true;
+        if (IsChainNode(n)) continue;
+        if (Adjacency.degrees[n] >= HUB_DEGREE) Adjacency.hubs[Adjacency.hubcount++] = n;
+        for (id i = 0; i < Nodes.esizes[n]; i++) {
+            id e = Nodes.edges[n][i];
+            if (pruned[e]) continue;
+            id chain = Adjacency.chains[e];
+            bool forward = Adjacency.chainEdges[Adjacency.chainOffsets[chain]] == e && Adjacency.chainEnds[chain][0] == n;
+            Adjacency.edges[k]   = e;
+            Adjacency.tails[k]   = OtherChainEnd(e);
+            Adjacency.others[k]  = Adjacency.chainEnds[chain][forward ? 1 : 0];
+            Adjacency.lengths[k] = Adjacency.chainLengths[chain];
+            k++;
+        }
+    }
+    Adjacency.offsets[Nodes.size] = k;
+    SDL_free(pruned);
+
+    ComputeFoodDistances();
+    for (int i = 0; i < k; i++) Adjacency.biases[i] = 1.0f;
+}
+
+/* Dijkstra from Food over the slots, also gives the optimal Nest to Food route length */
+void ComputeFoodDistances(void) {
+    for (id n = 0; n < Nodes.size; n++) Adjacency.distances[n] = -1.0f;
+    if (Food == EMPTY || Food >= Nodes.size) return;
+
+    struct { float distance; id node; } * heap = SDL_malloc((Adjacency.offsets[Nodes.size] + 1) * sizeof(*heap));
+    if (!heap) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    int size = 0;
+    heap[size++].node = Food;
+    heap[0].distance = 0.0f;
+    while (size > 0) {
+        float d = heap[0].distance;
+        id n = heap[0].node;
+
+        /* pop */
+        size--;
+        int i = 0;
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= size) break;
+            if (child + 1 < size && heap[child + 1].distance < heap[child].distance) child++;
+            if (heap[size].distance <= heap[child].distance) break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = heap[size];
+
+        if (Adjacency.distances[n] >= 0.0f) continue; /* settled with a shorter distance */
+        Adjacency.distances[n] = d;
+
+        for (int k = Adjacency.offsets[n]; k < Adjacency.offsets[n + 1]; k++) {
+            id other = Adjacency.others[k];
+            if (Adjacency.distances[other] >= 0.0f) continue;
+
+            /* push */
+            float od = d + Adjacency.lengths[k];
+            int j = size++;
+            while (j > 0 && heap[(j - 1) / 2].distance > od) {
+                heap[j] = heap[(j - 1) / 2];
+                j = (j - 1) / 2;
+            }
+            heap[j].distance = od;
+            heap[j].node = other;
+        }
+    }
+    SDL_free(heap);
+}
+
+void FreeAdjacency(void) {
+    SDL_free(Adjacency.offsets);
+    SDL_free(Adjacency.edges);
+    SDL_free(Adjacency.tails);
+    SDL_free(Adjacency.others);
+    SDL_free(Adjacency.lengths);
+    SDL_free(Adjacency.prefix);
+    SDL_free(Adjacency.biases);
+    SDL_free(Adjacency.dirty);
+    SDL_free(Adjacency.hubs);
+    SDL_free(Adjacency.degrees);
+    SDL_free(Adjacency.distances);
+    SDL_free(Adjacency.chains);
+    SDL_free(Adjacency.chainOffsets);
+    SDL_free(Adjacency.chainEdges);
+    SDL_free(Adjacency.chainEnds);
+    SDL_free(Adjacency.chainLengths);
+    Adjacency.offsets      = NULL;
+    Adjacency.edges        = NULL;
+    Adjacency.tails        = NULL;
+    Adjacency.others       = NULL;
+    Adjacency.lengths      = NULL;
+    Adjacency.prefix       = NULL;
+    Adjacency.biases       = NULL;
+    Adjacency.dirty        = NULL;
+    Adjacency.hubs         = NULL;
+    Adjacency.degrees      = NULL;
+    Adjacency.distances    = NULL;
+    Adjacency.chains       = NULL;
+    Adjacency.chainOffsets = NULL;
+    Adjacency.chainEdges   = NULL;
+    Adjacency.chainEnds    = NULL;
+    Adjacency.chainLengths = NULL;
+    Adjacency.chaincount   = 0;
+    Adjacency.hubcount     = 0;
+}
+
+/* Whole graph - empty graph without Nest and Food */
+void InitializeGraph(void) {
+    InitializeNodes();
+    InitializeGrids();
+    InitializeEdges();
+
+    Nest = EMPTY;
+    Food = EMPTY;
+
+    Ants.actives = 0;
+    Ants.count = 1;
+}
+
+void FreeGraph(void) {
+    FreeNodes();
+    FreeEdges();
+    FreeGrids();
+    FreePaths();
+    FreeAnts();
+    FreeAdjacency();
+    FreeWorkers();
+    FreeEvents();
+    FreeSnapshots();
+}
+
+/**********************************************/
+/************* Helper functions ***************/
+/**********************************************/
+/* Checks is there a node in the area, returns its idx, or EMPTY */
+static id FindNodeInArea(const struct nodes_s * nodes, const struct grids_s * grids, int x, int y, int area) {
+    if (x < grids->pxsize || x > WIN_WIDTH - grids->pxsize || y < grids->pxsize || y > WIN_HEIGHT - grids->pxsize) {
+       return EMPTY;
+    }
+
+    int g = (y / grids->pxsize) * grids->width + x / grids->pxsize;
+    for (int r = -1; r <= 1; r++) {
+        for (int c = -1; c <= 1; c++) {
+            int ng = g + (r * grids->width) + c;
+            for (int i = 0; i < 4; i++) {
+                id node = grids->nodes[ng][i];
+                if (node != EMPTY) {
+                    int dx = nodes->centers[node].x - x;
+                    int dy = nodes->centers[node].y - y;
+                    int distance = dx * dx + dy * dy;
+                    if (distance <= area) {
+                        return node;
+                    }
+                }
+            }
+        }
+    }
+    return EMPTY;
+}
+
+id SearchNodeInArea(int x, int y, int area) {
+    return FindNodeInArea(&Nodes, &Grids, x, y, area);
+}
+
+/* Adds the current node to the grid of the pos */
+static bool AddToGrid(const struct nodes_s * nodes, struct grids_s * grids, int x, int y) {
+    int g = (y / grids->pxsize) * grids->width + x / grids->pxsize;
+    for (int i = 0; i < 4; i++) {
+        if (grids->nodes[g][i] == EMPTY) { 
+            grids->nodes[g][i] = nodes->size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**********************************************/
+/********* Saving and loading graph ***********/
+/**********************************************/
+/* a save works on its own copy of the graph, so editing or running the colony does not wait for it */
+struct save_job_s {
+    coord_t    * centers;
+    id         * anodes;
+    id         * bnodes;
+    id           nodes;
+    id           edges;
+    unsigned     nest;
+    unsigned     food;
+    int          ants;
+    float        params[8];
+    char         path[64];
+};
+
+/* saves started from the main thread and not yet waited for, each one signals savesDone when written */
+static int savesRunning;
+static SDL_Semaphore * savesDone;
+
+/* formats and writes the snapshot, then reports with a GraphSavedEvent: code 1 on success, data1 the path to SDL_free */
+static int SDLCALL SaveGraphThread(void * data) {
+    struct save_job_s * job = data;
+    size_t size = ((size_t)job->nodes + job->edges) * 32 + 256;
+    char * buffer = SDL_malloc(size);
+    if (!buffer) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    size_t p = 0;
+    for (id n = 0; n < job->nodes; n++)
+        p += SDL_snprintf(buffer + p, size - p, "N %d %d\n", job->centers[n].x, job->centers[n].y);
+    for (id e = 0; e < job->edges; e++)
+        p += SDL_snprintf(buffer + p, size - p, "E %d %d\n", job->anodes[e], job->bnodes[e]);
+
+    p += SDL_snprintf(buffer + p, size - p, "-\n%u\n%u\n%d\n%.2f\n%.2f\n%.2f\n%.2f\n%.2f\n%.2f\n%.2f\n%.2f\n", 
+                     job->nest, job->food, job->ants, 
+                     job->params[0], job->params[1], job->params[2], job->params[3], 
+                     job->params[4], job->params[5], job->params[6], job->params[7]);
+
+    bool saved = SDL_SaveFile(job->path, buffer, p);
+    if (!saved) SDL_Log("Saving graph failed: %s\n", SDL_GetError());
+    SDL_free(buffer);
+
+    if (GraphSavedEvent) {
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = GraphSavedEvent;
+        event.user.code = saved;
+        event.user.data1 = SDL_strdup(job->path);
+        if (!SDL_PushEvent(&event)) SDL_free(event.user.data1);
+    }
+
+    SDL_free(job->centers);
+    SDL_free(job->anodes);
+    SDL_free(job->bnodes);
+    SDL_free(job);
+    SDL_SignalSemaphore(savesDone);
+    return 0;
+}
+
+/* saves the graph as GRAPH<ticks>.txt in the background, GraphSavedEvent tells when it is on disk */
+void SaveGraph(void) {
+    if (!GraphSavedEvent) GraphSavedEvent = SDL_RegisterEvents(1);
+
+    struct save_job_s * job = SDL_malloc(sizeof(*job));
+    if (!job) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    job->nodes   = Nodes.size;
+    job->edges   = Edges.size;
+    job->centers = SDL_malloc((job->nodes + 1) * sizeof(*job->centers));
+    job->anodes  = SDL_malloc((job->edges + 1) * sizeof(*job->anodes));
+    job->bnodes  = SDL_malloc((job->edges + 1) * sizeof(*job->bnodes));
+    if (!job->centers || !job->anodes || !job->bnodes) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    SDL_memcpy(job->centers, Nodes.centers, job->nodes * sizeof(*job->centers));
+    SDL_memcpy(job->anodes, Edges.anodes, job->edges * sizeof(*job->anodes));
+    SDL_memcpy(job->bnodes, Edges.bnodes, job->edges * sizeof(*job->bnodes));
+    job->nest = Nest;
+    job->food = Food;
+    job->ants = Ants.count;
+    float params[8] = { EvaporationRate, EvaporationInterval, PheromoneMin, PheromoneMax, Alpha, Beta, Q, AntSpeed };
+    SDL_memcpy(job->params, params, sizeof(params));
+    SDL_snprintf(job->path, sizeof(job->path), "GRAPH%07" SDL_PRIu64 ".txt", SDL_GetTicks());
+
+    if (!savesDone) savesDone = SDL_CreateSemaphore(0);
+    if (!savesDone) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    savesRunning++;
+    SDL_Thread * thread = SDL_CreateThread(SaveGraphThread, "SaveGraph", job);
+    if (thread) SDL_DetachThread(thread);
+    else SaveGraphThread(job); /* no thread, save in place */
+}
+
+/* blocks until the background saves are written, before quitting */
+void WaitGraphSaves(void) {
+    for (; savesRunning > 0; savesRunning--) SDL_WaitSemaphore(savesDone);
+    SDL_DestroySemaphore(savesDone);
+    savesDone = NULL;
+}
+
+/* ids go to and from the file as uint32 whatever the id width */
+static bool ReadIds(SDL_IOStream * file, id * ids, uint32_t count) {
+#if ID_BITS == 32
+    return SDL_ReadIO(file, ids, count * sizeof(*ids)) == count * sizeof(*ids);
+#else
+    uint32_t chunk[1024];
+    for (uint32_t i = 0; i < count; ) {
+        uint32_t n = count - i < 1024 ? count - i : 1024;
+        if (SDL_ReadIO(file, chunk, n * sizeof(*chunk)) != n * sizeof(*chunk)) return false;
+        for (uint32_t k = 0; k < n; k++) ids[i + k] = chunk[k] < MAX ? chunk[k] : EMPTY;
+        i += n;
+    }
+    return true;
+#endif
+}
+
+static bool WriteIds(SDL_IOStream * file, const id * ids, uint32_t count) {
+#if ID_BITS == 32
+    return SDL_WriteIO(file, ids, count * sizeof(*ids)) == count * sizeof(*ids);
+#else
+    uint32_t chunk[1024];
+    for (uint32_t i = 0; i < count; ) {
+        uint32_t n = count - i < 1024 ? count - i : 1024;
+        for (uint32_t k = 0; k < n; k++) chunk[k] = ids[i + k] == EMPTY ? 0xFFFFFFFFu : ids[i + k];
+        if (SDL_WriteIO(file, chunk, n * sizeof(*chunk)) != n * sizeof(*chunk)) return false;
+        i += n;
+    }
+    return true;
+#endif
+}
+
+/* writes the graph and the parameters in the binary format, LoadGraph reads it back */
+bool SaveGraphBinary(const char * path) {
+    struct graph_header_s header = {
+        .magic     = GRAPH_MAGIC, /* the terminating zero does not fit and is dropped */
+        .version   = GRAPH_VERSION,
+        .byteorder = GRAPH_BYTEORDER,
+        .nodes     = Nodes.size,
+        .edges     = Edges.size,
+        .nest      = Nest == EMPTY ? 0xFFFFFFFFu : Nest,
+        .food      = Food == EMPTY ? 0xFFFFFFFFu : Food,
+        .ants      = Ants.count,
+        .params    = { EvaporationRate, EvaporationInterval, PheromoneMin, PheromoneMax, Alpha, Beta, Q, AntSpeed, Weight }
+    };
+
+    SDL_IOStream * file = SDL_IOFromFile(path, "wb");
+    if (!file) {
+        SDL_Log("Saving graph failed: %s\n", SDL_GetError());
+        return false;
+    }
+    bool written = SDL_WriteIO(file, &header, sizeof(header)) == sizeof(header)
+                && SDL_WriteIO(file, Nodes.centers, Nodes.size * sizeof(*Nodes.centers)) == Nodes.size * sizeof(*Nodes.centers)
+                && WriteIds(file, Edges.anodes, Edges.size)
+                && WriteIds(file, Edges.bnodes, Edges.size)
+                && SDL_WriteIO(file, Edges.lengths, Edges.size * sizeof(*Edges.lengths)) == Edges.size * sizeof(*Edges.lengths);
+    if (!SDL_CloseIO(file)) written = false;
+
+    if (!written) SDL_Log("Saving graph failed: %s\n", SDL_GetError());
+    else SDL_Log("Graph saved as %s", path);
+    return written;
+}
+
+/* fills the empty graph from the arrays following the header: one read per array, 
+   no proximity or duplicate checks as the file was written from a valid graph, only the bounds are checked */
+static bool LoadGraphBinary(struct graph_s * graph, SDL_IOStream * file, const struct graph_header_s * header) {
+    struct nodes_s * nodes = &graph->nodes;
+    struct edges_s * edges = &graph->edges;
+    struct grids_s * grids = &graph->grids;
+    if (header->version != GRAPH_VERSION || header->byteorder != GRAPH_BYTEORDER) {
+        SDL_Log("Unsupported graph file version or byte order.\n");
+        return false;
+    }
+    if (header->nodes >= MAX || header->edges >= MAX) {
+        SDL_Log("Graph too large for %d bit ids, build with -DID_BITS=32.\n", ID_BITS);
+        return false;
+    }
+    id nodecount = header->nodes;
+    id edgecount = header->edges;
+    ReserveNodes(nodes, nodecount);
+    ReserveEdges(edges, edgecount);
+
+    if (SDL_ReadIO(file, nodes->centers, nodecount * sizeof(*nodes->centers)) != nodecount * sizeof(*nodes->centers) || 
+        !ReadIds(file, edges->anodes, edgecount) || !ReadIds(file, edges->bnodes, edgecount) || 
+        SDL_ReadIO(file, edges->lengths, edgecount * sizeof(*edges->lengths)) != edgecount * sizeof(*edges->lengths)) {
+        SDL_Log("Invalid graph file, it ends early.\n");
+        return false;
+    }
+    if (!ReportProgress(600)) return false;
+
+    for (id n = 0; n < nodecount; n++) {
+        coord_t c = nodes->centers[n];
+        if (c.x < 0 || c.x >= WIN_WIDTH || c.y < 0 || c.y >= WIN_HEIGHT) {
+            SDL_Log("Invalid graph file, node %u is off the window.\n", (unsigned)n);
+            return false;
+        }
+    }
+    for (id e = 0; e < edgecount; e++) {
+        if (edges->anodes[e] >= edges->bnodes[e] || edges->bnodes[e] >= nodecount || !(edges->lengths[e] > 0.0f)) {
+            SDL_Log("Invalid graph file, edge %u is broken.\n", (unsigned)e);
+            return false;
+        }
+        nodes->esizes[edges->anodes[e]]++;
+        nodes->esizes[edges->bnodes[e]]++;
+    }
+    if (!ReportProgress(700)) return false;
+
+    /* the edge lists are sized by the degrees counted above */
+    for (id n = 0; n < nodecount; n++) {
+        if (nodes->esizes[n] > nodes->ecapacities[n]) {
+            nodes->ecapacities[n] = nodes->esizes[n];
+            nodes->edges[n] = SDL_realloc(nodes->edges[n], nodes->ecapacities[n] * sizeof(*nodes->edges[n]));
+            if (!nodes->edges[n]) {
+                SDL_Log("Memory reallocation failed at line %d.\n", __LINE__);
+                exit(1);
+            }
+        }
+        nodes->esizes[n] = 0;
+    }
+    for (id e = 0; e < edgecount; e++) {
+        id a = edges->anodes[e], b = edges->bnodes[e];
+        nodes->edges[a][nodes->esizes[a]++] = e;
+        nodes->edges[b][nodes->esizes[b]++] = e;
+        SetEdgeGeometry(nodes, edges, e);
+        edges->pheromones[e] = header->params[2];
+        edges->epochs[e]     = edges->epoch;
+    }
+    edges->size = edgecount;
+
+    /* a node in a full grid cell still loads, it can not be picked with the mouse */
+    for (nodes->size = 0; nodes->size < nodecount; nodes->size++)
+        AddToGrid(nodes, grids, nodes->centers[nodes->size].x, nodes->centers[nodes->size].y);
+
+    graph->nest = header->nest < nodecount ? header->nest : EMPTY;
+    graph->food = header->food < nodecount ? header->food : EMPTY;
+    graph->ants = header->ants;
+    SDL_memcpy(graph->params, header->params, sizeof(graph->params));
+    graph->weight = true;
+    return true;
+}
+
+static const char * LineEnd(const char * l, const char * end) {
+    while (l < end && *l != '\n') l++;
+    return l;
+}
+
+/* reads a number the way %d does: leading blanks, a sign and digits */
+static bool ParseInt(const char ** text, const char * end, int * value) {
+    const char * p = *text;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    if (p >= end || *p < '0' || *p > '9') return false;
+
+    int64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (v <= SDL_MAX_SINT32) v = v * 10 + (*p - '0');
+        p++;
+    }
+    *value = (int)(negative ? -v : v);
+    *text = p;
+    return true;
+}
+
+/* duplicate edge set, open addressing on the (anode, bnode) pair, 0 = empty slot as bnode > anode */
+static bool InsertEdgeKey(uint64_t * keys, uint64_t mask, id a, id b) {
+    uint64_t key = ((uint64_t)a << 32) | b;
+    uint64_t h = (key * 0x9E3779B97F4A7C15ull) >> 20;
+    for (;; h++) {
+        uint64_t * slot = &keys[h & mask];
+        if (*slot == key) return false;
+        if (*slot == 0) {
+            *slot = key;
+            return true;
+        }
+    }
+}
+
+/* bulk ingestion of the N x y and E a b lines into the empty graph: counts the lines first to size the arrays once, 
+   then keeps and drops the same nodes and edges as AddNewNode and AddNewEdge would, without logging each 
+   and with a hash set for duplicates instead of the scan of the node's edges; 
+   returns the start of the parameters after the - line, NULL for an invalid file */
+static const char * LoadGraphText(struct graph_s * graph, const char * data, const char * end) {
+    struct nodes_s * nodes = &graph->nodes;
+    struct edges_s * edges = &graph->edges;
+    struct grids_s * grids = &graph->grids;
+    int64_t nodecount = 0, edgecount = 0;
+    for (const char * l = data; l < end; ) {
+        if (*l == 'N') nodecount++;
+        else if (*l == 'E') edgecount++;
+        else if (*l == '-') break;
+        const char * eol = LineEnd(l, end);
+        l = eol < end ? eol + 1 : end;
+    }
+    ReserveNodes(nodes, nodecount < MAX ? nodecount : MAX);
+    ReserveEdges(edges, edgecount < MAX ? edgecount : MAX);
+
+    uint64_t slots = 16;
+    while (slots < (uint64_t)edgecount * 2) slots *= 2;
+    uint64_t * keys = SDL_calloc(slots, sizeof(*keys));
+    if (!keys) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+
+    int min_xy = grids->pxsize + CIRCLE_RAD;
+    int max_x  = WIN_WIDTH  - grids->pxsize - CIRCLE_RAD;
+    int max_y  = WIN_HEIGHT - grids->pxsize - CIRCLE_RAD;
+    int dsquared = CIRCLE_SIZE * CIRCLE_SIZE * 4;
+    const char * params = NULL;
+    const char * l = data;
+    for (int lines = 1; l < end; lines++) {
+        if (lines % 4096 == 0 && !ReportProgress(1000 * (l - data) / (end - data))) break; /* canceled */
+        const char * eol = LineEnd(l, end);
+        const char * next = eol < end ? eol + 1 : end;
+        const char * p = l + 1;
+        int x, y;
+
+        if (*l == 'N') {
+            if (ParseInt(&p, eol, &x) && ParseInt(&p, eol, &y) && nodes->size < nodes->capacity) {
+                x = x < min_xy ? min_xy : x;
+                x = x > max_x  ? max_x  : x;
+                y = y < min_xy ? min_xy : y;
+                y = y > max_y  ? max_y  : y;
+                if (FindNodeInArea(nodes, grids, x, y, dsquared) == EMPTY && AddToGrid(nodes, grids, x, y)) /* too close ones are dropped */
+                    nodes->centers[nodes->size++] = (coord_t) { x, y };
+            }
+        } else if (*l == 'E') {
+            if (ParseInt(&p, eol, &x) && ParseInt(&p, eol, &y) && 
+                x >= 0 && y >= 0 && (id)x < nodes->size && (id)y < nodes->size && x != y) {
+                id a = x < y ? x : y;
+                id b = x < y ? y : x;
+                if (InsertEdgeKey(keys, slots - 1, a, b)) {
+                    id edge = edges->size;
+                    if (edge >= edges->capacity) {
+                        SDL_Log("Too many edges to allocate!\n");
+                        break;
+                    }
+                    AppendNodeEdge(nodes, a, edge);
+                    AppendNodeEdge(nodes, b, edge);
+                    float dX = nodes->centers[b].x - nodes->centers[a].x;
+                    float dY = nodes->centers[b].y - nodes->centers[a].y;
+                    edges->anodes[edge]     = a;
+                    edges->bnodes[edge]     = b;
+                    edges->lengths[edge]    = SDL_sqrt(dX * dX + dY * dY);
+                    SetEdgeGeometry(nodes, edges, edge);
+                    edges->epochs[edge]     = edges->epoch;
+                    edges->size++;
+                }
+            }
+        } else if (*l == '-') {
+            params = next;
+            break;
+        } else {
+            break;
+        }
+        l = next;
+    }
+
+    SDL_free(keys);
+    SDL_Log("Loaded %d nodes and %d edges.\n", (int)nodes->size, (int)edges->size);
+    return params;
+}
+
+static SDL_AtomicInt loadProgress = { -1 }; /* permille of the background load, -1 when none runs */
+static SDL_AtomicInt loadCancel;
+/* loads started from the main thread and not yet waited for, each one signals loadsDone when it returns; 
+   a finished load may still be handing its graph over */
+static int loadsRunning;
+static SDL_Semaphore * loadsDone;
+
+/* publishes the progress of a background load, false when it is canceled */
+static bool ReportProgress(int permille) {
+    if (SDL_GetAtomicInt(&loadProgress) < 0) return true; /* loading in place */
+    SDL_SetAtomicInt(&loadProgress, permille);
+    return !SDL_GetAtomicInt(&loadCancel);
+}
+
+static void DestroyGraph(struct graph_s * graph) {
+    DestroyNodes(&graph->nodes);
+    DestroyEdges(&graph->edges);
+    DestroyGrids(&graph->grids);
+    SDL_free(graph);
+}
+
+/* reads a text or, told by its magic, a binary graph file into a new graph, NULL on failure */
+static struct graph_s * ReadGraph(const char * path) {
+    struct graph_s * graph = SDL_malloc(sizeof(*graph));
+    if (!graph) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    CreateNodes(&graph->nodes);
+    CreateEdges(&graph->edges);
+    CreateGrids(&graph->grids);
+
+    SDL_IOStream * file = SDL_IOFromFile(path, "rb");
+    if (file) {
+        struct graph_header_s header;
+        if (SDL_ReadIO(file, &header, sizeof(header)) == sizeof(header) && 
+            SDL_memcmp(header.magic, GRAPH_MAGIC, sizeof(header.magic)) == 0) {
+            bool loaded = LoadGraphBinary(graph, file, &header);
+            SDL_CloseIO(file);
+            if (loaded) return graph;
+            DestroyGraph(graph);
+            return NULL;
+        }
+        SDL_CloseIO(file);
+    }
+
+    size_t size = 0;
+    char * data = SDL_LoadFile(path, &size);
+
+    if (!size) {
+        SDL_Log("No bytes loaded from the file. %s", SDL_GetError());
+        SDL_free(data);
+        DestroyGraph(graph);
+        return NULL;
+    }
+
+    unsigned nest, food;
+    const char * l = LoadGraphText(graph, data, data + size);
+    if (!ReportProgress(1000)) { /* canceled */
+        SDL_free(data);
+        DestroyGraph(graph);
+        return NULL;
+    }
+    if (!l || SDL_sscanf(l, "%u\n%u\n%d\n%f\n%f\n%f\n%f\n%f\n%f\n%f\n%f\n", 
+                     &nest, &food, &graph->ants, 
+                     &graph->params[0], &graph->params[1], &graph->params[2], &graph->params[3], 
+                     &graph->params[4], &graph->params[5], &graph->params[6], &graph->params[7]) != 11) {
+        SDL_Log("Invalid graph file.\n");
+        SDL_free(data);
+        DestroyGraph(graph);
+        return NULL;
+    }
+    SDL_free(data);
+
+    /* files saved with another id width store EMPTY differently */
+    graph->nest = nest < graph->nodes.size ? nest : EMPTY;
+    graph->food = food < graph->nodes.size ? food : EMPTY;
+    graph->weight = false;
+    for (id e = 0; e < graph->edges.size; e++) graph->edges.pheromones[e] = graph->params[2];
+    return graph;
+}
+
+/* replaces the nodes, edges and grids of the empty graph with the read one and takes its parameters, frees it */
+void InstallGraph(struct graph_s * graph) {
+    FreeNodes();
+    FreeEdges();
+    FreeGrids();
+    Nodes = graph->nodes;
+    Edges = graph->edges;
+    Grids = graph->grids;
+
+    Nest                = graph->nest;
+    Food                = graph->food;
+    Ants.count          = graph->ants;
+    EvaporationRate     = graph->params[0];
+    EvaporationInterval = graph->params[1];
+    PheromoneMin        = graph->params[2];
+    PheromoneMax        = graph->params[3];
+    Alpha               = graph->params[4];
+    Beta                = graph->params[5];
+    Q                   = graph->params[6];
+    AntSpeed            = graph->params[7];
+    if (graph->weight) Weight = graph->params[8];
+    SDL_free(graph);
+}
+
+/* loads a text or a binary graph file into the empty graph */
+bool LoadGraph(const char * path) {
+    struct graph_s * graph = ReadGraph(path);
+    if (!graph) return false;
+    InstallGraph(graph);
+    return true;
+}
+
+/* reads the graph and reports with a GraphLoadedEvent: code 1 on success, data1 the graph for InstallGraph, 
+   data2 the path to SDL_free */
+static int SDLCALL LoadGraphThread(void * data) {
+    char * path = data;
+    struct graph_s * graph = ReadGraph(path);
+    if (graph && SDL_GetAtomicInt(&loadCancel)) { /* read to the end, but nobody waits for it */
+        DestroyGraph(graph);
+        graph = NULL;
+    }
+
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = GraphLoadedEvent;
+    event.user.code = graph != NULL;
+    event.user.data1 = graph;
+    event.user.data2 = path;
+    SDL_SetAtomicInt(&loadProgress, -1); /* done before the event, so its handler can start the next load */
+    if (SDL_GetAtomicInt(&loadCancel) || !SDL_PushEvent(&event)) {
+        if (graph) DestroyGraph(graph);
+        SDL_free(path);
+    }
+    SDL_SignalSemaphore(loadsDone);
+    return 0;
+}
+
+/* reads the graph file on a worker thread while the current graph stays in use, GraphLoadedEvent hands it over; 
+   false when another load still runs */
+bool LoadGraphAsync(const char * path) {
+    if (!SDL_CompareAndSwapAtomicInt(&loadProgress, -1, 0)) return false;
+    if (!GraphLoadedEvent) GraphLoadedEvent = SDL_RegisterEvents(1);
+    SDL_SetAtomicInt(&loadCancel, 0);
+
+    char * copy = SDL_strdup(path);
+    if (!copy) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    if (!loadsDone) loadsDone = SDL_CreateSemaphore(0);
+    if (!loadsDone) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    loadsRunning++;
+    SDL_Thread * thread = SDL_CreateThread(LoadGraphThread, "LoadGraph", copy);
+    if (thread) SDL_DetachThread(thread);
+    else LoadGraphThread(copy); /* no thread, load in place */
+    return true;
+}
+
+/* permille of the running background load, -1 when none runs */
+int GraphLoadProgress(void) {
+    return SDL_GetAtomicInt(&loadProgress);
+}
+
+/* stops the running background load at its next progress point and waits for it, before quitting */
+void CancelGraphLoad(void) {
+    SDL_SetAtomicInt(&loadCancel, 1);
+    for (; loadsRunning > 0; loadsRunning--) SDL_WaitSemaphore(loadsDone);
+    SDL_DestroySemaphore(loadsDone);
+    loadsDone = NULL;
+}
+
+/* doubles a capacity up to MAX, EMPTY (= MAX) is never a valid id; returns 0 when already full */
+static int64_t GrowCapacity(int64_t capacity) {
+    if (capacity >= MAX) return 0;
+    return capacity * 2 < MAX ? capacity * 2 : MAX;
+}
+
+/* aligned, padded float array for the vector kernels: keeps the first size values, zeroes the rest */
+static float * ReallocVector(float * old, int size, int capacity) {
+    size_t padded = VECTOR_PADDED(capacity);
+    float * vector = SDL_aligned_alloc(VECTOR_BYTES, padded * sizeof(*vector));
+    if (!vector) return NULL;
+
+    if (old) SDL_memcpy(vector, old, size * sizeof(*vector));
+    SDL_memset(vector + size, 0, (padded - size) * sizeof(*vector));
+    SDL_aligned_free(old);
+    return vector;
+}
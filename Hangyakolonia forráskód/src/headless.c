@@ -0,0 +1,170 @@
+#include <global.h>
+#include <stdio.h>
+
+/* command line front-end of the engine: no window, renderer, fonts or textures */
+
+static void PrintUsage(const char * exe) {
+    SDL_Log("Usage: %s <graph file> [options]\n"
+            "  -t <seconds>   simulated time to run (default 60)\n"
+            "  -d <seconds>   time step of one tick (default 0.016)\n"
+            "  -r <seconds>   simulated time between reports, 0 = off (default 1)\n"
+            "  -s <seed>      random seed, 0 = current time (default 0)\n"
+            "  -j <threads>   threads updating the ants, 0 = all cores (default 1)\n"
+            "  -l <0|1>       lazy evaporation, edges decay only when the ants touch them (default 0)\n"
+            "  -e <0|1>       event-driven, only node arrivals are handled, ignores -j (default 0)\n"
+            "  -g <exponent>  bias towards the shortest remaining distance to Food, 0 = off (default 0)\n"
+            "  -m <file>      stream convergence metrics, JSON lines for a .jsonl file, CSV otherwise\n"
+            "  -n <ticks>     ticks between metrics rows (default 60)\n"
+            "  -x <ticks>     stop after this many ticks, 0 = off (default 0)\n"
+            "  -c <ticks>     ticks between convergence checks (default 60)\n"
+            "  -E <entropy>   stop when the pheromone entropy falls below this, 0 = off (default 0)\n"
+            "  -k <checks>    stop when the best walk has not improved in this many checks, 0 = off (default 0)\n"
+            "  -b <factor>    stop when the mean branching factor falls below this, 0 = off (default 0)\n"
+            "  -A <alpha>     pheromone exponent, -B <beta> length exponent, -Q <q> deposit, -R <rate> evaporation rate, \n"
+            "  -W <weight>    deposit weight, -N <ants> ant count; override the defaults and the graph file\n"
+            "  -w <file>      write the loaded graph in the binary format, loads faster than the text one\n"
+            "  -p <0|1>       print one result row to stdout at the end (default 0):\n"
+            "                 ticks,time,optimum,best,mean,optimal,entropy,converged,wall\n", exe);
+}
+
+static void Report(void) {
+    struct engine_state_s state;
+    EngineGetState(&state);
+    SDL_Log("t=%.2f ticks=%" SDL_PRIu64 " actives=%d/%d foraging=%d homing=%d pheromones=%.2f\n",
+            state.time, state.ticks, state.actives, state.count, state.foraging, state.homing, state.pheromones);
+}
+
+int main(int argc, char * argv[]) {
+    const char * path = NULL;
+    float duration = 60.0f;
+    float dt = 1.0f / 60.0f;
+    float reportInterval = 1.0f;
+    Uint64 seed = 0;
+    int threads = 1;
+    bool lazy = false;
+    bool events = false;
+    const char * metrics = NULL;
+    int metricsInterval = 60;
+    struct convergence_s convergence = { 0, 60, 0.0f, 0, 0.0f };
+    float alpha = 0.0f, beta = 0.0f, q = 0.0f, rate = 0.0f, weight = 0.0f;
+    bool hasAlpha = false, hasBeta = false, hasQ = false, hasRate = false, hasWeight = false; /* Beta may be negative */
+    int ants = 0;
+    bool result = false;
+    const char * binary = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        if (arg[0] == '-' && i + 1 < argc) {
+            const char * value = argv[++i];
+            switch (arg[1]) {
+                case 't': duration = SDL_atof(value); break;
+                case 'd': dt = SDL_atof(value); break;
+                case 'r': reportInterval = SDL_atof(value); break;
+                case 's': seed = SDL_strtoull(value, NULL, 10); break;
+                case 'j': threads = SDL_atoi(value); break;
+                case 'l': lazy = SDL_atoi(value) != 0; break;
+                case 'e': events = SDL_atoi(value) != 0; break;
+                case 'g': FoodBias = SDL_atof(value); break;
+                case 'm': metrics = value; break;
+                case 'n': metricsInterval = SDL_atoi(value); break;
+                case 'x': convergence.maxTicks = SDL_strtoull(value, NULL, 10); break;
+                case 'c': convergence.interval = SDL_atoi(value); break;
+                case 'E': convergence.entropy = SDL_atof(value); break;
+                case 'k': convergence.patience = SDL_atoi(value); break;
+                case 'b': convergence.branching = SDL_atof(value); break;
+                case 'A': alpha = SDL_atof(value); hasAlpha = true; break;
+                case 'B': beta = SDL_atof(value); hasBeta = true; break;
+                case 'Q': q = SDL_atof(value); hasQ = true; break;
+                case 'R': rate = SDL_atof(value); hasRate = true; break;
+                case 'W': weight = SDL_atof(value); hasWeight = true; break;
+                case 'N': ants = SDL_atoi(value); break;
+                case 'p': result = SDL_atoi(value) != 0; break;
+                case 'w': binary = value; break;
+                default: PrintUsage(argv[0]); return 1;
+            }
+        } else if (!path && arg[0] != '-') {
+            path = arg;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path || dt <= 0.0f || duration <= 0.0f) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    /* random seed */
+    if (seed == 0) {
+        SDL_Time t = 0;
+        SDL_GetCurrentTime(&t);
+        seed = t;
+    }
+    SDL_srand(seed);
+    EngineSetThreads(threads);
+    EngineSetLazyEvaporation(lazy);
+    EngineSetEventDriven(events);
+    EngineSetConvergence(&convergence);
+
+    if (!EngineInit(path)) {
+        SDL_Log("Failed to load file: %s", path);
+        return 1;
+    }
+    if (binary && !SaveGraphBinary(binary)) {
+        EngineFree();
+        return 1;
+    }
+
+    /* parameter overrides, the colony restarts with them from the same random state */
+    if (hasAlpha || hasBeta || hasQ || hasRate || hasWeight || ants > 0) {
+        if (hasAlpha)  Alpha = alpha;
+        if (hasBeta)   Beta = beta;
+        if (hasQ)      Q = q;
+        if (hasRate)   EvaporationRate = rate;
+        if (hasWeight) Weight = weight;
+        if (ants > 0)       EngineSetAntCount(ants);
+        if (!ValidateGraph()) {
+            EngineFree();
+            return 1;
+        }
+        SDL_srand(seed);
+        EngineStart();
+    }
+    if (metrics && !EngineSetMetrics(metrics, metricsInterval)) {
+        EngineFree();
+        return 1;
+    }
+
+    double simulated = 0.0;
+    float reportTimer = 0.0f;
+    Uint64 start = SDL_GetTicksNS();
+    while (simulated < duration && !EngineConverged()) {
+        EngineStep(dt);
+        simulated += dt;
+
+        reportTimer += dt;
+        if (reportInterval > 0.0f && reportTimer >= reportInterval) {
+            reportTimer -= reportInterval;
+            Report();
+        }
+    }
+    double wallSecs = (SDL_GetTicksNS() - start) / 1e9;
+
+    struct engine_state_s state;
+    EngineGetState(&state);
+    Report();
+    SDL_Log("Simulated %.2f s in %.3f s wall time (%.0f ticks/s)\n",
+            state.time, wallSecs, wallSecs > 0.0 ? state.ticks / wallSecs : 0.0);
+
+    if (result) { /* read by the sweep runner */
+        struct engine_metrics_s m;
+        EngineGetMetrics(&m);
+        printf("%" SDL_PRIu64 ",%.3f,%.2f,%.2f,%.2f,%.2f,%.4f,%d,%.3f\n",
+               state.ticks, state.time, m.optimum, m.best, m.mean, m.optimal, m.entropy, EngineConverged() ? 1 : 0, wallSecs);
+        fflush(stdout);
+    }
+
+    EngineFree();
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include <global.h>
+#include <stdlib.h>
+
+/* parameter sweep: runs one headless colony process per parameter set and seed, as many at once as there are cores,
+   every colony has its own graph, ants and pheromones; the result rows go to a CSV table in job order */
+
+#define MAX_VALUES      64
+#define RESULT_SIZE     192
+
+/* a swept parameter: listed values for the grid, or a lo:hi range sampled in random mode */
+struct param_s {
+    const char * name;
+    const char * flag;   /* headless option */
+    char         option; /* sweep option */
+    float        values[MAX_VALUES];
+    int          count;
+    float        lo;
+    float        hi;
+    bool         range;
+    bool         integer;
+};
+
+static struct param_s params[] = {
+    { "alpha",  "-A", 'a', {0}, 0, 0.0f, 0.0f, false, false },
+    { "beta",   "-B", 'b', {0}, 0, 0.0f, 0.0f, false, false },
+    { "q",      "-Q", 'q', {0}, 0, 0.0f, 0.0f, false, false },
+    { "rate",   "-R", 'r', {0}, 0, 0.0f, 0.0f, false, false },
+    { "weight", "-W", 'w', {0}, 0, 0.0f, 0.0f, false, false },
+    { "ants",   "-N", 'c', {0}, 0, 0.0f, 0.0f, false, true  },
+};
+#define PARAM_COUNT     ((int)SDL_arraysize(params))
+
+struct job_s {
+    float        values[PARAM_COUNT]; /* set for the parameters given, params[i].count > 0 */
+    Uint64       seed;
+    char         result[RESULT_SIZE];
+    int          exitcode;
+};
+
+static struct job_s * jobs      = NULL;
+static int            jobcount  = 0;
+static SDL_AtomicInt  nextJob;
+static SDL_AtomicInt  doneJobs;
+static const char   * headless  = NULL;
+static const char   * graphPath = NULL;
+static char        ** extraArgs = NULL; /* passed on to every colony after -- */
+static int            extraCount = 0;
+
+static void PrintUsage(const char * exe) {
+    SDL_Log("Usage: %s <graph file> [options] [-- headless options]\n"
+            "  -o <file>       results table (default sweep.csv)\n"
+            "  -j <processes>  colonies running at once, 0 = all cores (default 0)\n"
+            "  -s <seeds>      seeds 1..seeds run for every parameter set (default 1)\n"
+            "  -n <samples>    random parameter sets instead of the grid, 0 = grid (default 0)\n"
+            "  -z <seed>       random seed of the sampling (default 1)\n"
+            "  -x <file>       headless executable (default Hangyakolonia-headless next to this one)\n"
+            "  -a <values>     Alpha, -b Beta, -q Q, -r EvaporationRate, -w Weight, -c ant count\n"
+            "values: a list 0.5,1,2 or a range lo:hi:step for the grid, a range lo:hi is sampled in random mode;\n"
+            "parameters not given keep their defaults, e.g. -- -t 300 -k 20 stops every colony on convergence\n", exe);
+}
+
+/* "v1,v2,..." or "lo:hi[:step]" */
+static bool ParseValues(struct param_s * p, const char * text) {
+    const char * colon = SDL_strchr(text, ':');
+    if (colon) {
+        char * end = NULL;
+        p->lo = SDL_strtod(text, &end);
+        if (end != colon) return false;
+        p->hi = SDL_strtod(colon + 1, &end);
+        if (end == colon + 1 || p->hi < p->lo) return false;
+        p->range = true;
+
+        float step = *end == ':' ? SDL_strtod(end + 1, NULL) : 0.0f;
+        p->count = 0;
+        if (step <= 0.0f) { /* only sampled, the grid takes both ends */
+            p->values[p->count++] = p->lo;
+            if (p->hi > p->lo) p->values[p->count++] = p->hi;
+            return true;
+        }
+        for (int i = 0; i < MAX_VALUES && p->lo + i * step <= p->hi + step * 1e-3f; i++)
+            p->values[p->count++] = p->lo + i * step;
+        return true;
+    }
+
+    p->count = 0;
+    p->range = false;
+    while (*text && p->count < MAX_VALUES) {
+        char * end = NULL;
+        p->values[p->count++] = SDL_strtod(text, &end);
+        if (end == text) return false;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return p->count > 0 && *text == '\0';
+}
+
+/* the cartesian product of the listed values, every set with each seed */
+static void BuildGrid(int seeds) {
+    int sets = 1;
+    for (int i = 0; i < PARAM_COUNT; i++) if (params[i].count > 0) sets *= params[i].count;
+    jobcount = sets * seeds;
+    jobs = SDL_calloc(jobcount, sizeof(*jobs));
+    if (!jobs) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    for (int s = 0; s < sets; s++) {
+        int rest = s;
+        float values[PARAM_COUNT];
+        for (int i = PARAM_COUNT - 1; i >= 0; i--) {
+            if (params[i].count == 0) { values[i] = 0.0f; continue; } /* not given, not passed on */
+            values[i] = params[i].values[rest % params[i].count];
+            rest /= params[i].count;
+        }
+        for (int k = 0; k < seeds; k++) {
+            struct job_s * job = &jobs[s * seeds + k];
+            SDL_memcpy(job->values, values, sizeof(values));
+            job->seed = k + 1;
+        }
+    }
+}
+
+/* samples uniform in the ranges, or one of the listed values */
+static void BuildSamples(int samples, int seeds) {
+    jobcount = samples * seeds;
+    jobs = SDL_calloc(jobcount, sizeof(*jobs));
+    if (!jobs) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    for (int s = 0; s < samples; s++) {
+        float values[PARAM_COUNT];
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            struct param_s * p = &params[i];
+            if (p->count == 0) values[i] = 0.0f;
+            else if (p->range) values[i] = p->lo + SDL_randf() * (p->hi - p->lo);
+            else values[i] = p->values[SDL_rand(p->count)];
+            if (p->integer) values[i] = SDL_roundf(values[i]);
+        }
+        for (int k = 0; k < seeds; k++) {
+            struct job_s * job = &jobs[s * seeds + k];
+            SDL_memcpy(job->values, values, sizeof(values));
+            job->seed = k + 1;
+        }
+    }
+}
+
+/* runs one colony to the end and keeps the last line of its stdout */
+static void RunJob(struct job_s * job) {
+    char texts[PARAM_COUNT][32];
+    char seed[32];
+    const char * args[PARAM_COUNT * 2 + 16 + 64];
+    int count = 0;
+
+    args[count++] = headless;
+    args[count++] = graphPath;
+    args[count++] = "-r"; args[count++] = "0";
+    args[count++] = "-j"; args[count++] = "1";
+    args[count++] = "-p"; args[count++] = "1";
+    SDL_snprintf(seed, sizeof(seed), "%" SDL_PRIu64, job->seed);
+    args[count++] = "-s"; args[count++] = seed;
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        if (params[i].count == 0) continue; /* keeps the value of the graph file */
+        SDL_snprintf(texts[i], sizeof(texts[i]), params[i].integer ? "%.0f" : "%g", job->values[i]);
+        args[count++] = params[i].flag;
+        args[count++] = texts[i];
+    }
+    for (int i = 0; i < extraCount && i < 64; i++) args[count++] = extraArgs[i];
+    args[count] = NULL;
+
+    SDL_PropertiesID props = SDL_CreateProperties();
+    SDL_SetPointerProperty(props, SDL_PROP_PROCESS_CREATE_ARGS_POINTER, (void *)args);
+    SDL_SetNumberProperty(props, SDL_PROP_PROCESS_CREATE_STDIN_NUMBER, SDL_PROCESS_STDIO_NULL);
+    SDL_SetNumberProperty(props, SDL_PROP_PROCESS_CREATE_STDOUT_NUMBER, SDL_PROCESS_STDIO_APP);
+    SDL_SetNumberProperty(props, SDL_PROP_PROCESS_CREATE_STDERR_NUMBER, SDL_PROCESS_STDIO_NULL); /* the colony's log */
+    SDL_Process * process = SDL_CreateProcessWithProperties(props);
+    SDL_DestroyProperties(props);
+
+    job->exitcode = -1;
+    job->result[0] = '\0';
+    if (!process) {
+        SDL_Log("Starting %s failed: %s\n", headless, SDL_GetError());
+        return;
+    }
+
+    size_t size = 0;
+    char * output = SDL_ReadProcess(process, &size, &job->exitcode);
+    if (output) {
+        while (size > 0 && (output[size - 1] == '\n' || output[size - 1] == '\r')) output[--size] = '\0';
+        char * line = output + size;
+        while (line > output && line[-1] != '\n') line--;
+        SDL_strlcpy(job->result, line, sizeof(job->result));
+        SDL_free(output);
+    }
+    SDL_DestroyProcess(process);
+}
+
+static int SDLCALL RunnerThread(void * data) {
+    for (;;) {
+        int j = SDL_AddAtomicInt(&nextJob, 1);
+        if (j >= jobcount) break;
+        RunJob(&jobs[j]);
+
+        int done = SDL_AddAtomicInt(&doneJobs, 1) + 1;
+        if (done % 10 == 0 || done == jobcount) SDL_Log("%d/%d colonies done\n", done, jobcount);
+    }
+    return 0;
+}
+
+static bool WriteResults(const char * path) {
+    SDL_IOStream * file = SDL_IOFromFile(path, "w");
+    if (!file) {
+        SDL_Log("Opening results file failed: %s\n", SDL_GetError());
+        return false;
+    }
+    for (int i = 0; i < PARAM_COUNT; i++) SDL_IOprintf(file, "%s,", params[i].name);
+    SDL_IOprintf(file, "seed,exit,ticks,time,optimum,best,mean,optimal,entropy,converged,wall\n");
+
+    for (int j = 0; j < jobcount; j++) {
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            if (params[i].count == 0) SDL_IOprintf(file, ",");
+            else SDL_IOprintf(file, params[i].integer ? "%.0f," : "%g,", jobs[j].values[i]);
+        }
+        SDL_IOprintf(file, "%" SDL_PRIu64 ",%d,", jobs[j].seed, jobs[j].exitcode);
+        if (jobs[j].exitcode == 0 && jobs[j].result[0]) SDL_IOprintf(file, "%s\n", jobs[j].result);
+        else SDL_IOprintf(file, ",,,,,,,,\n");
+    }
+    return SDL_CloseIO(file);
+}
+
+int main(int argc, char * argv[]) {
+    const char * output = "sweep.csv";
+    int processes = 0;
+    int seeds = 1;
+    int samples = 0;
+    Uint64 sampleSeed = 1;
+    char * defaultHeadless = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        if (SDL_strcmp(arg, "--") == 0) {
+            extraArgs = &argv[i + 1];
+            extraCount = argc - i - 1;
+            break;
+        }
+        if (arg[0] == '-' && i + 1 < argc) {
+            const char * value = argv[++i];
+            struct param_s * param = NULL;
+            for (int p = 0; p < PARAM_COUNT; p++) if (params[p].option == arg[1]) param = &params[p];
+            if (param) {
+                if (!ParseValues(param, value)) {
+                    SDL_Log("Invalid values for %s: %s\n", param->name, value);
+                    return 1;
+                }
+                continue;
+            }
+            switch (arg[1]) {
+                case 'o': output = value; break;
+                case 'j': processes = SDL_atoi(value); break;
+                case 's': seeds = SDL_atoi(value); break;
+                case 'n': samples = SDL_atoi(value); break;
+                case 'z': sampleSeed = SDL_strtoull(value, NULL, 10); break;
+                case 'x': headless = value; break;
+                default: PrintUsage(argv[0]); return 1;
+            }
+        } else if (!graphPath && arg[0] != '-') {
+            graphPath = arg;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!graphPath || seeds < 1 || samples < 0 || extraCount > 64) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (!headless) {
+        const char * base = SDL_GetBasePath();
+        SDL_asprintf(&defaultHeadless, "%sHangyakolonia-headless%s", base ? base : "",
+#ifdef SDL_PLATFORM_WINDOWS
+                     ".exe"
+#else
+                     ""
+#endif
+                     );
+        headless = defaultHeadless;
+    }
+
+    SDL_srand(sampleSeed);
+    if (samples > 0) BuildSamples(samples, seeds);
+    else BuildGrid(seeds);
+
+    if (processes <= 0) processes = SDL_GetNumLogicalCPUCores();
+    if (processes > jobcount) processes = jobcount;
+    SDL_Log("Running %d colonies, %d at once\n", jobcount, processes);
+
+    SDL_Thread ** threads = SDL_malloc(processes * sizeof(*threads));
+    if (!threads) {
+        SDL_Log("Memory allocation failed at line %d.\n", __LINE__);
+        exit(1);
+    }
+    SDL_SetAtomicInt(&nextJob, 0);
+    SDL_SetAtomicInt(&doneJobs, 0);
+
+    Uint64 start = SDL_GetTicksNS();
+    int started = 0;
+    for (int t = 0; t < processes; t++) {
+        threads[started] = SDL_CreateThread(RunnerThread, "SweepRunner", NULL);
+        if (threads[started]) started++;
+        else SDL_Log("Starting runner thread failed: %s\n", SDL_GetError());
+    }
+    /* the runners share the job queue, so without any of them the jobs run here */
+    if (started == 0) RunnerThread(NULL);
+    for (int t = 0; t < started; t++) SDL_WaitThread(threads[t], NULL);
+    double wallSecs = (SDL_GetTicksNS() - start) / 1e9;
+
+    int failed = 0;
+    for (int j = 0; j < jobcount; j++) if (jobs[j].exitcode != 0 || !jobs[j].result[0]) failed++;
+    bool written = WriteResults(output);
+    SDL_Log("%d colonies in %.1f s wall time, %d failed, results in %s\n", jobcount, wallSecs, failed, output);
+
+    SDL_free(threads);
+    SDL_free(jobs);
+    SDL_free(defaultHeadless);
+    return written && failed == 0 ? 0 : 1;
+}
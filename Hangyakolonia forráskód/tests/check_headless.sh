@@ -0,0 +1,37 @@
+#!/bin/sh
+# checks on the headless build, run from the source folder after ./build_headless.sh
+# HEADLESS=path/to/binary ./tests/check_headless.sh to check another build
+HEADLESS=${HEADLESS:-./build/Hangyakolonia-headless}
+failed=0
+
+check() { # name, then the command that must succeed
+    name=$1
+    shift
+    if "$@"; then echo "ok   $name"; else echo "FAIL $name"; failed=1; fi
+}
+
+# rings off a junction are pruned whole, with the ring on a ring and the dead end on a ring they leave behind
+rings() {
+    "$HEADLESS" tests/ring.txt -t 10 -r 0 -s 1 2>&1 | grep -q "Pruned 9 nodes and 12 edges"
+}
+check "rings pruned" rings
+
+# -k stops on the best walk found at the Food, so sampling metrics must not move the stop tick
+patience() {
+    metrics=${TMPDIR:-/tmp}/hangyakolonia-metrics.$$.csv
+    plain=$("$HEADLESS" tests/ring.txt -t 600 -r 0 -s 42 -k 5 -c 60 2>&1 | grep "Converged at tick")
+    sampled=$("$HEADLESS" tests/ring.txt -t 600 -r 0 -s 42 -k 5 -c 60 -m "$metrics" -n 7 2>&1 | grep "Converged at tick")
+    rm -f "$metrics"
+    [ -n "$plain" ] && [ "$plain" = "$sampled" ]
+}
+check "patience ignores -m" patience
+
+# reports only read the colony, so a lazy-evaporation run ends the same whatever -r is
+reports() {
+    quiet=$("$HEADLESS" tests/ring.txt -t 120 -r 0 -s 42 -l 1 -p 1 2>/dev/null | cut -d, -f1-8)
+    chatty=$("$HEADLESS" tests/ring.txt -t 120 -r 0.05 -s 42 -l 1 -p 1 2>/dev/null | cut -d, -f1-8)
+    [ -n "$quiet" ] && [ "$quiet" = "$chatty" ]
+}
+check "reports ignore -r" reports
+
+exit $failed